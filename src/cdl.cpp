@@ -0,0 +1,103 @@
+#include "types.h"
+#include "fceu.h"
+#include "cart.h"
+#include "cdl.h"
+#include "driver.h"
+#include "utils/memory.h"
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+int cdl_enabled = 0;
+uint8 *cdl_map = 0;
+uint32 cdl_size = 0;
+
+static std::string cdl_filename;
+static int cdl_interval = 0;
+static int cdl_framecount = 0;
+
+void FCEU_CDLogDPCM(uint32 A, int size)
+{
+	for (int i = 0; i < size; i++)
+		FCEU_CDLMark((A + i) & 0xFFFF, 0x40 | 2 | (((A + i) >> 11) & 0x0c));
+}
+
+bool FCEUI_BeginCDLog(const char *fn, int interval)
+{
+	FCEUI_EndCDLog();
+
+	if (!GameInfo || !PRGptr[0] || !PRGsize[0])
+		return false;
+
+	cdl_size = PRGsize[0];
+	cdl_map = (uint8*)FCEU_dmalloc(cdl_size + 1);
+	if (!cdl_map)
+		return false;
+	memset(cdl_map, 0, cdl_size + 1);
+
+	// coverage accumulates across sessions: merge whatever an earlier run left behind
+	FILE *fp = FCEUD_UTF8fopen(fn, "rb");
+	if (fp)
+	{
+		uint8 buf[4096];
+		uint32 pos = 0;
+		size_t got;
+		while (pos < cdl_size && (got = fread(buf, 1, sizeof(buf) < cdl_size - pos ? sizeof(buf) : cdl_size - pos, fp)) > 0)
+		{
+			for (size_t i = 0; i < got; i++)
+				cdl_map[pos + i] |= buf[i];
+			pos += got;
+		}
+		fclose(fp);
+	}
+
+	cdl_filename = fn;
+	cdl_interval = interval;
+	cdl_framecount = 0;
+	cdl_enabled = 1;
+	return true;
+}
+
+bool FCEUI_CDLogDump()
+{
+	if (!cdl_map)
+		return false;
+
+	FILE *fp = FCEUD_UTF8fopen(cdl_filename.c_str(), "wb");
+	if (!fp)
+		return false;
+	bool ok = fwrite(cdl_map, 1, cdl_size, fp) == cdl_size;
+	fclose(fp);
+	return ok;
+}
+
+void FCEUI_EndCDLog()
+{
+	if (!cdl_map)
+		return;
+
+	cdl_enabled = 0;
+	if (!FCEUI_CDLogDump())
+		FCEU_printf("Error writing code/data log \"%s\".\n", cdl_filename.c_str());
+	FCEU_dfree(cdl_map);
+	cdl_map = 0;
+	cdl_size = 0;
+	cdl_filename.clear();
+}
+
+bool FCEUI_CDLogActive()
+{
+	return cdl_enabled != 0;
+}
+
+void FCEU_CDLogFrame()
+{
+	if (!cdl_enabled || cdl_interval <= 0)
+		return;
+	if (++cdl_framecount >= cdl_interval)
+	{
+		cdl_framecount = 0;
+		FCEUI_CDLogDump();
+	}
+}
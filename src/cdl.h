@@ -0,0 +1,45 @@
+#ifndef _CDL_H_
+#define _CDL_H_
+
+#include "types.h"
+
+// Standalone code/data logger. Unlike the debugger's logger it is fed straight
+// from the cpu's memory accessors, so it works without the debugger and costs
+// a single table update per access. Output uses the .cdl layout of the
+// windows Code/Data Logger (PRG part only).
+
+extern int cdl_enabled;
+extern uint8 *cdl_map;  // one byte per PRG byte, plus a spare byte that soaks up accesses outside PRG
+extern uint32 cdl_size;
+
+// from cart.h, which has no include guard
+extern uint8 *Page[32];
+extern uint8 *PRGptr[32];
+
+// ORs flags into the byte mapped at A, unless it was already logged as the same kind (code/data).
+// The DPCM bit (0x40) is independent of that and always goes in.
+static INLINE void FCEU_CDLMark(uint32 A, uint8 flags)
+{
+	// compare host addresses as integers: the page may be unmapped or point into RAM/WRAM
+	uint8 *page = Page[A >> 11];
+	uintptr_t ofs = page ? (uintptr_t)page + A - (uintptr_t)PRGptr[0] : cdl_size;
+	uint8 *p = &cdl_map[ofs < cdl_size ? ofs : cdl_size];
+	uint8 logged = *p;
+	*p = logged | (flags & ((uint8)(((logged & flags & 3) != 0) - 1) | 0x40));
+}
+
+// called for every cpu read; a fetch at PC is code, anything else is data
+static INLINE void FCEU_CDLRead(uint32 A, uint32 PC)
+{
+	uint8 flags = (A == PC) ? (1 | (((A & 0x8000) >> 8) ^ 0x80)) : 2;
+	FCEU_CDLMark(A, flags | ((A >> 11) & 0x0c));
+}
+
+void FCEU_CDLogDPCM(uint32 A, int size);
+void FCEU_CDLogFrame();
+
+// FCEUI_BeginCDLog/FCEUI_EndCDLog are declared in driver.h
+bool FCEUI_CDLogDump();
+bool FCEUI_CDLogActive();
+
+#endif
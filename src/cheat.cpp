@@ -59,6 +59,12 @@ void FCEU_CheatAddRAM(int s, uint32 A, uint8 *p)
 		CheatRPtrs[AB+x]=p-A;
 }
 
+uint8 *FCEU_CheatGetRAMBlock(uint32 A)
+{
+	A&=0xFC00;
+	return CheatRPtrs[A>>10]?CheatRPtrs[A>>10]+A:0;
+}
+
 
 struct CHEATF {
 	struct CHEATF *next;
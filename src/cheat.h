@@ -1,5 +1,6 @@
 void FCEU_CheatResetRAM(void);
 void FCEU_CheatAddRAM(int s, uint32 A, uint8 *p);
+uint8 *FCEU_CheatGetRAMBlock(uint32 A); // host memory behind the 1KB block containing A, or 0
 
 void FCEU_LoadGameCheats(FILE *override);
 void FCEU_FlushGameCheats(FILE *override, int nosave);
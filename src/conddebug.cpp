@@ -50,6 +50,7 @@
 #include <cstring>
 #include <cassert>
 #include <cctype>
+#include <vector>
 
 uint16 debugLastAddress = 0; // used by 'T' and 'R' conditions
 uint8 debugLastOpcode; // used to evaluate 'W' condition
@@ -77,6 +78,12 @@ void freeTree(Condition* c)
 	if (c->lhs) freeTree(c->lhs);
 	if (c->rhs) freeTree(c->rhs);
 
+	if (c->program)
+	{
+		free(c->program->code);
+		free(c->program);
+	}
+
 	free(c);
 }
 
@@ -519,5 +526,87 @@ Condition* generateCondition(const char* str)
 	c = Connect(&str);
 
 	if (!c || next != 0) return 0;
-	else return c;
+
+	// Conditions are evaluated on every instruction a breakpoint may fire on,
+	// so flatten the tree once here. Without a program evaluate() walks the tree.
+	c->program = compileCondition(c);
+
+	return c;
+}
+
+struct CondCompiler
+{
+	std::vector<CondInstr> code;
+	int depth;
+	int maxDepth;
+
+	void emit(unsigned int instr, unsigned int value, int stackChange)
+	{
+		CondInstr i = { instr, value };
+		code.push_back(i);
+		depth += stackChange;
+		if (depth > maxDepth) maxDepth = depth;
+	}
+
+	// Mirrors how evaluate() computes one side of a node
+	void operand(Condition* sub, unsigned int type, unsigned int value, unsigned int regName)
+	{
+		switch (type)
+		{
+			case TYPE_PC_BANK: emit(CI_PC_BANK, 0, 1); return;
+			case TYPE_DATA_BANK: emit(CI_DATA_BANK, 0, 1); return;
+			case TYPE_VALUE_READ: emit(CI_VALUE_READ, 0, 1); return;
+			case TYPE_VALUE_WRITE: emit(CI_VALUE_WRITE, 0, 1); return;
+		}
+
+		if (sub)
+			node(sub);
+		else if (type == TYPE_ADDR || type == TYPE_NUM)
+			emit(CI_PUSH, value, 1);
+		else
+			emit(CI_REG, regName, 1);
+
+		if (type == TYPE_ADDR)
+			emit(CI_MEM, 0, 0);
+	}
+
+	void node(Condition* c)
+	{
+		operand(c->lhs, c->type1, c->value1, c->value1);
+
+		if (c->op)
+		{
+			// evaluate() looks a right hand register up by type2; the parser
+			// never builds such a node, but keep both evaluators in step
+			operand(c->rhs, c->type2, c->value2, c->type2);
+			emit(CI_BINARY, c->op, -1);
+		}
+	}
+};
+
+// Flattens a condition tree into a postfix program; returns 0 if it is too deep
+CondProgram* compileCondition(Condition* c)
+{
+	CondCompiler cc;
+	cc.depth = cc.maxDepth = 0;
+	cc.node(c);
+
+	if (cc.maxDepth > COND_MAX_DEPTH)
+		return 0;
+
+	CondProgram* p = (CondProgram*)FCEU_dmalloc(sizeof(CondProgram));
+	if (!p)
+		return 0;
+
+	p->length = cc.code.size();
+	p->depth = cc.maxDepth;
+	p->code = (CondInstr*)FCEU_dmalloc(p->length * sizeof(CondInstr));
+	if (!p->code)
+	{
+		free(p);
+		return 0;
+	}
+	memcpy(p->code, &cc.code[0], p->length * sizeof(CondInstr));
+
+	return p;
 }
@@ -45,9 +45,35 @@
 #define OP_OR 11
 #define OP_AND 12
 
+// Instructions of a compiled condition
+#define CI_PUSH 0			// push value
+#define CI_REG 1			// push the register or flag named by value
+#define CI_MEM 2			// replace the top of the stack by the byte at that address
+#define CI_PC_BANK 3		// push the bank of PC
+#define CI_DATA_BANK 4		// push the bank of the last accessed address
+#define CI_VALUE_READ 5		// push the byte at the last accessed address
+#define CI_VALUE_WRITE 6	// push the value the current opcode writes
+#define CI_BINARY 7			// pop two values and push the result of operator value
+
+#define COND_MAX_DEPTH 32
+
 extern uint16 debugLastAddress;
 extern uint8 debugLastOpcode;
 
+struct CondInstr
+{
+	unsigned int code;
+	unsigned int value;
+};
+
+// Postfix form of a condition tree, run on a value stack of at most depth entries
+struct CondProgram
+{
+	CondInstr* code;
+	int length;
+	int depth;
+};
+
 //mbg merge 7/18/06 turned into sane c++
 struct Condition
 {
@@ -61,9 +87,12 @@ struct Condition
 
 	unsigned int type2;
 	unsigned int value2;
+
+	CondProgram* program;	// compiled form of the whole tree, only set on the root
 };
 
 void freeTree(Condition* c);
 Condition* generateCondition(const char* str);
+CondProgram* compileCondition(Condition* c);
 
 #endif
@@ -201,6 +201,8 @@ unsigned int NewBreak(const char* name, int start, int end, unsigned int type, c
 	watchpoint[num].desc = (char*)malloc(strlen(name) + 1);
 	strcpy(watchpoint[num].desc, name);
 
+	InvalidateWatchpointIndex();
+
 	return checkCondition(condition, num);
 }
 
@@ -336,6 +338,53 @@ uint8 evaluateWrite(uint8 opcode, uint16 address)
 	return 0;
 }
 
+static int applyOperator(unsigned int op, int value1, int value2)
+{
+	switch (op)
+	{
+		case OP_EQ: return value1 == value2;
+		case OP_NE: return value1 != value2;
+		case OP_GE: return value1 >= value2;
+		case OP_LE: return value1 <= value2;
+		case OP_G: return value1 > value2;
+		case OP_L: return value1 < value2;
+		case OP_MULT: return value1 * value2;
+		case OP_DIV: return (value2==0) ? 0 : (value1 / value2);
+		case OP_PLUS: return value1 + value2;
+		case OP_MINUS: return value1 - value2;
+		case OP_OR: return value1 || value2;
+		case OP_AND: return value1 && value2;
+	}
+	return value1;
+}
+
+// Runs a compiled condition; gives the same result as evaluate() on its tree
+int evaluateProgram(const CondProgram* p)
+{
+	int stack[COND_MAX_DEPTH];
+	int sp = 0;
+
+	for (const CondInstr* i = p->code, *end = p->code + p->length; i != end; i++)
+	{
+		switch (i->code)
+		{
+			case CI_PUSH: stack[sp++] = i->value; break;
+			case CI_REG: stack[sp++] = getValue(i->value); break;
+			case CI_MEM: stack[sp-1] = GetMem(stack[sp-1]); break;
+			case CI_PC_BANK: stack[sp++] = getBank(_PC); break;
+			case CI_DATA_BANK: stack[sp++] = getBank(debugLastAddress); break;
+			case CI_VALUE_READ: stack[sp++] = GetMem(debugLastAddress); break;
+			case CI_VALUE_WRITE: stack[sp++] = evaluateWrite(debugLastOpcode, debugLastAddress); break;
+			case CI_BINARY:
+				sp--;
+				stack[sp-1] = applyOperator(i->value, stack[sp-1], stack[sp]);
+				break;
+		}
+	}
+
+	return stack[0];
+}
+
 // Evaluates a condition
 int evaluate(Condition* c)
 {
@@ -393,21 +442,7 @@ int evaluate(Condition* c)
 		case TYPE_VALUE_WRITE: value2 = evaluateWrite(debugLastOpcode, debugLastAddress); break;
 	}
 
-		switch (c->op)
-		{
-			case OP_EQ: f = value1 == value2; break;
-			case OP_NE: f = value1 != value2; break;
-			case OP_GE: f = value1 >= value2; break;
-			case OP_LE: f = value1 <= value2; break;
-			case OP_G: f = value1 > value2; break;
-			case OP_L: f = value1 < value2; break;
-			case OP_MULT: f = value1 * value2; break;
-			case OP_DIV: f = (value2==0) ? 0 : (value1 / value2); break;
-			case OP_PLUS: f = value1 + value2; break;
-			case OP_MINUS: f = value1 - value2; break;
-			case OP_OR: f = value1 || value2; break;
-			case OP_AND: f = value1 && value2; break;
-		}
+		f = applyOperator(c->op, value1, value2);
 	}
 
 	return f;
@@ -415,7 +450,9 @@ int evaluate(Condition* c)
 
 int condition(watchpointinfo* wp)
 {
-	return wp->cond == 0 || evaluate(wp->cond);
+	if (wp->cond == 0)
+		return 1;
+	return wp->cond->program ? evaluateProgram(wp->cond->program) : evaluate(wp->cond);
 }
 
 
@@ -494,6 +531,57 @@ int u; //deleteme
 int skipdebug; //deleteme
 int numWPs;
 
+// Watchpoint index: for each 256-byte page of cpu address space, the set of
+// enabled watchpoints whose range touches it (bit i = watchpoint[i]). It lets
+// breakpoint() run the full checks only for watchpoints that can fire on the
+// current instruction. Rebuilt lazily after InvalidateWatchpointIndex().
+static uint64 wpPageMask[256];
+static uint64 wpPPUMask;		// enabled PPU and sprite memory watchpoints
+static uint64 wpForbidMask;		// enabled forbid watchpoints
+static int wpCPUList[64];		// enabled cpu memory watchpoints, in list order
+static int wpCPUCount;
+static bool wpIndexValid = false;
+static int wpIndexedCount = 0;
+
+void InvalidateWatchpointIndex()
+{
+	wpIndexValid = false;
+}
+
+static void UpdateWatchpointIndex()
+{
+	if (wpIndexValid && wpIndexedCount == numWPs)
+		return;
+
+	memset(wpPageMask, 0, sizeof(wpPageMask));
+	wpPPUMask = wpForbidMask = 0;
+	wpCPUCount = 0;
+
+	for (int i = 0; i < numWPs && i < 64; i++)
+	{
+		const watchpointinfo& wp = watchpoint[i];
+		const uint64 bit = (uint64)1 << i;
+
+		if (!(wp.flags & WP_E))
+			continue;
+		if (wp.flags & WP_F)
+			wpForbidMask |= bit;
+		if (wp.flags & (BT_P | BT_S))
+		{
+			wpPPUMask |= bit;
+			continue;
+		}
+
+		wpCPUList[wpCPUCount++] = i;
+		int last = wp.endaddress > wp.address ? wp.endaddress : wp.address;
+		for (int page = wp.address >> 8; page <= (last >> 8); page++)
+			wpPageMask[page] |= bit;
+	}
+
+	wpIndexValid = true;
+	wpIndexedCount = numWPs;
+}
+
 bool break_asap = false;
 // for CPU cycles and Instructions counters
 uint64 total_cycles_base = 0;
@@ -543,10 +631,11 @@ void BreakHit(int bp_num, bool force)
 		}
 
 		//check to see whether we fall in any forbid zone
-		for (int i = 0; i < numWPs; i++)
+		UpdateWatchpointIndex();
+		for (int i = 0; i < numWPs && (wpForbidMask >> i); i++)
 		{
 			watchpointinfo& wp = watchpoint[i];
-			if(!(wp.flags & WP_F) || !(wp.flags & WP_E))
+			if(!((wpForbidMask >> i) & 1))
 				continue;
 
 			if (condition(&wp))
@@ -657,11 +746,32 @@ static void breakpoint(uint8 *opcode, uint16 A, int size) {
 		default: break;
 	}
 
+	UpdateWatchpointIndex();
+
+	//only watchpoints covering the accessed address, PC or the stack page can fire
+	uint64 candidates = wpPageMask[A >> 8] | wpPageMask[_PC >> 8] | wpPageMask[1];
+	if (((A >= 0x2000) && (A < 0x4000)) || (A == 0x4014))
+		candidates |= wpPPUMask;
+
+	//StackNextIgnorePC is consumed by the first enabled cpu watchpoint not matching brk_type
+	int stackIgnoreWP = -1;
+	if (StackNextIgnorePC == _PC)
+	{
+		for (j = 0; j < wpCPUCount; j++)
+		{
+			if (!(watchpoint[wpCPUList[j]].flags & brk_type))
+			{
+				stackIgnoreWP = wpCPUList[j];
+				break;
+			}
+		}
+	}
+
 	#define BREAKHIT(x) { breakHit = (x); goto STOPCHECKING; }
 	int breakHit = -1;
-	for (i = 0; i < numWPs; i++)
+	for (i = 0; i < numWPs && (candidates >> i); i++)
 	{
-		if ((watchpoint[i].flags & WP_E))
+		if (((candidates >> i) & 1) && (watchpoint[i].flags & WP_E))
 		{
 			if (watchpoint[i].flags & BT_P)
 			{
@@ -738,10 +848,9 @@ static void breakpoint(uint8 *opcode, uint16 A, int size) {
 							}
 						}
 					}
-					if (StackNextIgnorePC == _PC)
+					if (i == stackIgnoreWP)
 					{
 						// Used to make it ignore the unannounced stack code one time
-						StackNextIgnorePC = 0xFFFF;
 					} else
 					{
 						if (StackAddrBackup != -1 && (X.S < StackAddrBackup) && (stackop==0))
@@ -790,6 +899,9 @@ static void breakpoint(uint8 *opcode, uint16 A, int size) {
 	} //loop across all breakpoints
 
 STOPCHECKING:
+
+	if (stackIgnoreWP != -1 && (breakHit == -1 || breakHit > stackIgnoreWP))
+		StackNextIgnorePC = 0xFFFF;
 	
 	//Update the stack address with the current one, now that changes have registered.
 	//ZEROMUS THINKS IT MAKES MORE SENSE HERE
@@ -67,6 +67,7 @@ int GetRomAddress(int A);
 uint8 *GetNesPRGPointer(int A);
 uint8 *GetNesCHRPointer(int A);
 void KillDebugger();
+void InvalidateWatchpointIndex(); //call after changing a watchpoint's range or flags
 uint8 GetMem(uint16 A);
 uint8 GetPPUMem(uint8 A);
 
@@ -0,0 +1,159 @@
+#include "types.h"
+#include "fceu.h"
+#include "driver.h"
+#include "emufile.h"
+#include "state.h"
+#include "movie.h"
+#include "digest.h"
+
+#include <cstdio>
+#include <cstring>
+
+int digest_stepping = 0;
+
+static FILE *digest_file = 0;
+static int digest_frame = -1;
+static uint32 digest_step = 0;
+
+static const char digest_magic[4] = {'F','C','D','G'};
+#define DIGEST_VERSION 1
+#define DIGEST_RECORD  28
+
+static void put32(uint8 *p, uint32 v)
+{
+	p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24;
+}
+
+static uint32 get32(const uint8 *p)
+{
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32)p[3] << 24);
+}
+
+static void WriteRecord(uint32 step, uint32 pc)
+{
+	uint32 digest[FCEUSS_DIGESTS];
+	uint8 rec[DIGEST_RECORD];
+
+	FCEUSS_Digest(digest);
+	put32(rec, currFrameCounter);
+	put32(rec + 4, step);
+	put32(rec + 8, pc);
+	for (int i = 0; i < FCEUSS_DIGESTS; i++)
+		put32(rec + 12 + i * 4, digest[i]);
+	fwrite(rec, 1, DIGEST_RECORD, digest_file);
+}
+
+bool FCEUI_BeginDigestLog(const char *fn, int instructionFrame)
+{
+	FCEUI_EndDigestLog();
+
+	if (!(digest_file = FCEUD_UTF8fopen(fn, "wb")))
+		return false;
+
+	uint8 hdr[8];
+	memcpy(hdr, digest_magic, 4);
+	put32(hdr + 4, DIGEST_VERSION);
+	fwrite(hdr, 1, 8, digest_file);
+	digest_frame = instructionFrame;
+	return true;
+}
+
+void FCEUI_EndDigestLog(void)
+{
+	if (!digest_file)
+		return;
+	fclose(digest_file);
+	digest_file = 0;
+	digest_stepping = 0;
+}
+
+void FCEU_DigestFrameBegin(void)
+{
+	digest_stepping = digest_file && currFrameCounter == digest_frame;
+	digest_step = 0;
+}
+
+void FCEU_DigestFrameEnd(void)
+{
+	digest_stepping = 0;
+	if (digest_file)
+		WriteRecord(DIGEST_FRAME_END, 0);
+}
+
+void FCEU_DigestInstruction(uint32 pc)
+{
+	WriteRecord(digest_step++, pc);
+}
+
+static const char *digest_parts[FCEUSS_DIGESTS] = { "cpu", "ppu", "apu", "mapper" };
+
+int FCEUI_CompareDigestLogs(const char *fnA, const char *fnB)
+{
+	FILE *a = FCEUD_UTF8fopen(fnA, "rb");
+	FILE *b = FCEUD_UTF8fopen(fnB, "rb");
+	uint8 ha[8], hb[8];
+	int ret = -1;
+
+	if (!a || !b || fread(ha, 1, 8, a) != 8 || fread(hb, 1, 8, b) != 8
+		|| memcmp(ha, digest_magic, 4) || memcmp(hb, digest_magic, 4))
+	{
+		FCEU_PrintError("Couldn't read the digest logs.");
+		goto done;
+	}
+
+	for (;;)
+	{
+		uint8 ra[DIGEST_RECORD], rb[DIGEST_RECORD];
+		bool ea = fread(ra, 1, DIGEST_RECORD, a) != DIGEST_RECORD;
+		bool eb = fread(rb, 1, DIGEST_RECORD, b) != DIGEST_RECORD;
+
+		if (ea || eb)
+		{
+			if (ea && eb)
+			{
+				FCEU_printf("The digest logs match.\n");
+				ret = 0;
+			}
+			else
+			{
+				FCEU_printf("The digest logs match up to frame %u, where %s ends.\n", get32(ea ? rb : ra), ea ? fnA : fnB);
+				ret = 1;
+			}
+			break;
+		}
+
+		if (!memcmp(ra, rb, DIGEST_RECORD))
+			continue;
+
+		uint32 frame = get32(ra), step = get32(ra + 4);
+		if (frame != get32(rb) || step != get32(rb + 4))
+		{
+			// one log has instruction records here and the other doesn't
+			FCEU_printf("The digest logs were not recorded with the same settings (frame %u / %u).\n", frame, get32(rb));
+			break;
+		}
+
+		char parts[64] = "";
+		for (int i = 0; i < FCEUSS_DIGESTS; i++)
+		{
+			if (get32(ra + 12 + i * 4) != get32(rb + 12 + i * 4))
+			{
+				strcat(parts, " ");
+				strcat(parts, digest_parts[i]);
+			}
+		}
+		if (step == DIGEST_FRAME_END)
+			FCEU_printf("First difference at the end of frame %u:%s\nRecord both runs again with the digest frame set to %u to find the instruction.\n", frame, parts, frame);
+		else if (get32(ra + 8) != get32(rb + 8))
+			FCEU_printf("First difference in frame %u before instruction %u: PC $%04X / $%04X\n", frame, step, get32(ra + 8), get32(rb + 8));
+		else
+			FCEU_printf("First difference in frame %u before instruction %u (PC $%04X):%s\n", frame, step, get32(ra + 8), parts);
+		ret = 1;
+		break;
+	}
+
+done:
+	if (a) fclose(a);
+	if (b) fclose(b);
+	return ret;
+}
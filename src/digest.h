@@ -0,0 +1,22 @@
+#ifndef _DIGEST_H_
+#define _DIGEST_H_
+
+#include "types.h"
+
+// State digest log. After every frame a record with the frame number and the
+// FCEUSS_Digest of the cpu, ppu, apu and mapper state is appended; during one
+// chosen frame a record is also written before every cpu instruction, so two
+// runs that first differ in that frame can be compared instruction by
+// instruction. Records are 28 bytes, little endian:
+//   u32 frame, u32 step (instruction index, or DIGEST_FRAME_END), u32 pc, u32 digest[4]
+// FCEUI_BeginDigestLog/FCEUI_EndDigestLog/FCEUI_CompareDigestLogs are declared in driver.h
+
+#define DIGEST_FRAME_END 0xFFFFFFFF
+
+extern int digest_stepping;
+
+void FCEU_DigestFrameBegin(void);
+void FCEU_DigestFrameEnd(void);
+void FCEU_DigestInstruction(uint32 pc);
+
+#endif
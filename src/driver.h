@@ -60,6 +60,18 @@ void FCEUD_NetworkClose(void);
 bool FCEUI_BeginWaveRecord(const char *fn);
 int FCEUI_EndWaveRecord(void);
 
+//Starts the standalone code/data logger, merging into fn if it exists; the log is
+//rewritten every interval frames (0 = only when logging stops or the game closes).
+bool FCEUI_BeginCDLog(const char *fn, int interval);
+void FCEUI_EndCDLog(void);
+
+//Writes a digest of the cpu/ppu/apu/mapper state after every frame to fn. During frame instructionFrame
+//(-1 = none) a digest is also written before every cpu instruction.
+bool FCEUI_BeginDigestLog(const char *fn, int instructionFrame);
+void FCEUI_EndDigestLog(void);
+//Reports the first record where two digest logs differ. Returns 0 if they match, 1 if not, -1 on error.
+int FCEUI_CompareDigestLogs(const char *fnA, const char *fnB);
+
 void FCEUI_ResetNES(void);
 void FCEUI_PowerNES(void);
 
@@ -108,6 +120,20 @@ bool FCEUI_Initialize();
 //Emulates a frame.
 void FCEUI_Emulate(uint8 **, int32 **, int32 *, int);
 
+//Compute-only mode: FCEUI_Emulate keeps everything the CPU can observe exact (sprite 0 hits, zapper light
+//sensing, mapper PPU hooks, APU length counters and IRQs) but returns no picture and no sound, and skips
+//the work that only produces them. Meant for seeking and batch runs. Channel waveform state (noise shift
+//register, triangle step) is not advanced, so savestates made in this mode differ there.
+//With sound set, sound is still produced and only the picture is skipped.
+void FCEUI_SetComputeOnly(bool on, bool sound=false);
+bool FCEUI_GetComputeOnly(void);
+
+//Per-scanline change information for the frame last returned by FCEUI_Emulate, as displayed (overlays included).
+//Both arrays have 240 entries. The lines are hashed on the first call for a frame, not while emulating, and a line
+//is dirty when its hash differs from the last frame that was asked about (every line is dirty the first time).
+const uint8 *FCEUI_GetDirtyLines(void);
+const uint64 *FCEUI_GetLineHashes(void);
+
 //Closes currently loaded game
 void FCEUI_CloseGame(void);
 
@@ -203,6 +229,35 @@ int FCEUI_SetCheat(uint32 which, const char *name, int32 a, int32 v, int compare
 void FCEUI_CheatSearchShowExcluded(void);
 void FCEUI_CheatSearchSetCurrentAsOriginal(void);
 
+//RAM search over all cheat-visible memory, for 1, 2 or 4 byte little-endian values.
+//A filter compares the current values against the previous pass (or against value
+//when specific is set) and keeps the addresses for which the comparison holds.
+enum ERamSearchOp
+{
+	FCEU_RS_LESS,
+	FCEU_RS_GREATER,
+	FCEU_RS_LESSEQUAL,
+	FCEU_RS_GREATEREQUAL,
+	FCEU_RS_EQUAL,
+	FCEU_RS_NOTEQUAL,
+	FCEU_RS_DIFFERENTBY, //current - previous == value
+};
+
+int32 FCEUI_RamSearchReset(int size, bool sign);
+int32 FCEUI_RamSearchFilter(int op, bool specific, int32 value);
+int32 FCEUI_RamSearchGetCount(void);
+void FCEUI_RamSearchGet(int (*callb)(uint32 a, int64 last, int64 current, void *data), void *data);
+void FCEUI_RamSearchExclude(uint32 a);
+
+//Hashes every rom under dir (including zip/gz members) with the given number of worker
+//threads (0 = one per core) and writes an index of path/size/mtime/crc32/md5 to indexFile.
+//Files whose size and mtime match the previous index are not hashed again.
+//Returns the number of roms in the index, or -1 if it couldn't be written.
+int FCEUI_ScanROMs(const char *dir, const char *indexFile, int threads, int *hashed = 0);
+//Looks up the crc32/md5 recorded for path, if the file hasn't changed since it was indexed.
+//The index is parsed once and cached until its size or mtime changes; safe to call from any thread.
+bool FCEUI_LookupROMIndex(const char *indexFile, const char *path, uint32 *crc32, uint8 md5[16]);
+
 //.rom
 #define FCEUIOD_ROMS    0	//Roms
 #define FCEUIOD_NV      1	//NV = nonvolatile. save data.
@@ -0,0 +1,288 @@
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <zlib.h>
+
+#include "../../types.h"
+#include "../../driver.h"
+#include "../../palette.h"
+#include "avdump.h"
+
+#define AVDUMP_W        256
+#define AVDUMP_H        240
+#define AVDUMP_PLANE    (AVDUMP_W*AVDUMP_H)
+#define AVDUMP_SLOTS    32   // packets the encoder may fall behind before the emulator waits for it
+#define AVDUMP_KEYINT   300  // frames between keyframes
+
+struct AVPacket
+{
+	uint8 tag;
+	std::vector<uint8> data;
+};
+
+static FILE *avfile = 0;
+static std::thread *avworker = 0;
+static std::atomic<bool> avstop(false);
+
+// Single producer (emulation thread), single consumer (worker) ring.
+// head is only written by the producer and tail only by the consumer, so pushing and
+// popping is lock free. avmutex is only taken to sleep: by the worker when the ring is
+// empty, by the emulator when it is full. Each side stores its index and then reads the
+// other one (both seq_cst), so whichever side moves second sees the ring was empty (or
+// full) and wakes the sleeper; nothing is ever dropped.
+static AVPacket avring[AVDUMP_SLOTS];
+static std::atomic<uint32> avhead(0), avtail(0);
+static std::mutex avmutex;
+static std::condition_variable avwake, avspace;
+
+static uint8 lastPalette[768*3];
+static bool havePalette;
+static uint32 stalls;
+
+// worker state
+static std::vector<uint8> prevFrame, work, zbuf;
+static bool haveFrame;
+static uint32 sinceKey, repeats, frames, dupes;
+
+static void write32(uint32 v, uint8 *p)
+{
+	p[0] = v; p[1] = v>>8; p[2] = v>>16; p[3] = v>>24;
+}
+
+static void write16(uint16 v, uint8 *p)
+{
+	p[0] = v; p[1] = v>>8;
+}
+
+static void WritePacket(uint8 tag, const uint8 *data, uint32 len)
+{
+	uint8 hdr[5];
+	hdr[0] = tag;
+	write32(len, hdr+1);
+	fwrite(hdr, 1, 5, avfile);
+	if(len) fwrite(data, 1, len, avfile);
+}
+
+static void FlushRepeats()
+{
+	if(!repeats) return;
+	uint8 buf[4];
+	write32(repeats, buf);
+	WritePacket('R', buf, 4);
+	repeats = 0;
+}
+
+static void EncodeFrame(std::vector<uint8> &frame)
+{
+	frames++;
+	if(haveFrame && !memcmp(&frame[0], &prevFrame[0], AVDUMP_PLANE*2))
+	{
+		// static screens (pauses, menus, fades held on a colour) cost nothing
+		repeats++;
+		dupes++;
+		return;
+	}
+	FlushRepeats();
+
+	bool key = !haveFrame || sinceKey >= AVDUMP_KEYINT;
+	const uint8 *src = &frame[0];
+	if(!key)
+	{
+		const uint8 *a = &frame[0], *b = &prevFrame[0];
+		uint8 *d = &work[0];
+		for(int i=0;i<AVDUMP_PLANE*2;i++)
+			d[i] = a[i] ^ b[i];
+		src = d;
+	}
+
+	uLongf zlen = zbuf.size();
+	compress2(&zbuf[0], &zlen, src, AVDUMP_PLANE*2, 1);
+	WritePacket(key ? 'K' : 'D', &zbuf[0], zlen);
+
+	sinceKey = key ? 1 : sinceKey + 1;
+	prevFrame.swap(frame);
+	if(frame.size() != AVDUMP_PLANE*2) frame.resize(AVDUMP_PLANE*2);
+	haveFrame = true;
+}
+
+static void WorkerProc()
+{
+	for(;;)
+	{
+		uint32 t = avtail.load(std::memory_order_relaxed);
+		if(avhead.load() == t)
+		{
+			std::unique_lock<std::mutex> lock(avmutex);
+			avwake.wait(lock, [t] { return avhead.load() != t || avstop.load(); });
+			if(avhead.load() == t)
+				break;
+		}
+
+		AVPacket &p = avring[t % AVDUMP_SLOTS];
+		if(p.tag == 'V')
+			EncodeFrame(p.data);
+		else
+		{
+			if(p.tag == 'P') FlushRepeats();
+			WritePacket(p.tag, &p.data[0], p.data.size());
+		}
+
+		avtail.store(t+1);
+		if(avhead.load() - t == AVDUMP_SLOTS)
+		{
+			// the ring was full, so the emulator may be asleep in BeginPush
+			std::lock_guard<std::mutex> lock(avmutex);
+			avspace.notify_one();
+		}
+	}
+	FlushRepeats();
+}
+
+// Returns the next free slot. The dump is lossless, so if the encoder is a whole ring
+// behind the emulator waits for it rather than drop anything.
+static AVPacket *BeginPush()
+{
+	uint32 h = avhead.load(std::memory_order_relaxed);
+	if(h - avtail.load() == AVDUMP_SLOTS)
+	{
+		stalls++;
+		std::unique_lock<std::mutex> lock(avmutex);
+		avspace.wait(lock, [h] { return h - avtail.load() < AVDUMP_SLOTS; });
+	}
+	return &avring[h % AVDUMP_SLOTS];
+}
+
+static void EndPush()
+{
+	uint32 h = avhead.load(std::memory_order_relaxed);
+	avhead.store(h+1);
+	if(avtail.load() == h)
+	{
+		// the ring was empty, so the worker may be asleep
+		std::lock_guard<std::mutex> lock(avmutex);
+		avwake.notify_one();
+	}
+}
+
+bool AVDump_Active()
+{
+	return avfile != 0;
+}
+
+bool AVDump_Begin(const char *fname, uint32 fps, uint32 soundrate)
+{
+	AVDump_End();
+
+	if(!(avfile = FCEUD_UTF8fopen(fname, "wb")))
+		return false;
+
+	uint8 hdr[28];
+	memcpy(hdr, "FCXAV\x1A", 6);
+	write16(AVDUMP_VERSION, hdr+6);
+	write16(AVDUMP_W, hdr+8);
+	write16(AVDUMP_H, hdr+10);
+	write32(fps, hdr+12);
+	write32(soundrate, hdr+16);
+	write16(1, hdr+20);
+	write16(16, hdr+22);
+	write32(0, hdr+24);   // frame count, patched by AVDump_End
+	fwrite(hdr, 1, sizeof(hdr), avfile);
+
+	for(int i=0;i<AVDUMP_SLOTS;i++)
+		avring[i].data.reserve(AVDUMP_PLANE*2);
+	prevFrame.resize(AVDUMP_PLANE*2);
+	work.resize(AVDUMP_PLANE*2);
+	zbuf.resize(compressBound(AVDUMP_PLANE*2));
+	avhead = avtail = 0;
+	havePalette = haveFrame = false;
+	stalls = 0;
+	sinceKey = repeats = frames = dupes = 0;
+
+	avstop = false;
+	avworker = new std::thread(WorkerProc);
+	return true;
+}
+
+void AVDump_End()
+{
+	if(!avfile) return;
+
+	{
+		std::lock_guard<std::mutex> lock(avmutex);
+		avstop = true;
+		avwake.notify_one();
+	}
+	avworker->join();
+	delete avworker;
+	avworker = 0;
+
+	uint8 buf[4];
+	write32(frames, buf);
+	fseek(avfile, 24, SEEK_SET);
+	fwrite(buf, 1, 4, avfile);
+	fclose(avfile);
+	avfile = 0;
+
+	FCEU_printf("A/V dump: %u frames, %u duplicates.\n", frames, dupes);
+	if(stalls)
+		FCEU_printf("A/V dump: the encoder fell behind %u times; emulation waited for it.\n", stalls);
+}
+
+// Queues a palette packet if any of the 768 entries changed since the last one.
+static void CheckPalette()
+{
+	uint8 pal[768*3];
+	for(int x=0;x<256;x++)
+		FCEUD_GetPalette(x, &pal[x*3], &pal[x*3+1], &pal[x*3+2]);
+	if(palo)
+	{
+		for(int x=0;x<512;x++)
+		{
+			pal[768+x*3] = palo[x].r;
+			pal[768+x*3+1] = palo[x].g;
+			pal[768+x*3+2] = palo[x].b;
+		}
+	}
+	else memset(pal+768, 0, 512*3);
+
+	if(havePalette && !memcmp(pal, lastPalette, sizeof(pal)))
+		return;
+
+	AVPacket *p = BeginPush();
+	memcpy(lastPalette, pal, sizeof(pal));
+	havePalette = true;
+	p->tag = 'P';
+	p->data.assign(pal, pal+sizeof(pal));
+	EndPush();
+}
+
+void AVDump_Video(const uint8 *xbuf, const uint8 *deemph)
+{
+	if(!avfile) return;
+
+	CheckPalette();
+
+	AVPacket *p = BeginPush();
+	p->tag = 'V';
+	p->data.resize(AVDUMP_PLANE*2);
+	memcpy(&p->data[0], xbuf, AVDUMP_PLANE);
+	if(deemph)
+		memcpy(&p->data[AVDUMP_PLANE], deemph, AVDUMP_PLANE);
+	else
+		memset(&p->data[AVDUMP_PLANE], 0, AVDUMP_PLANE);
+	EndPush();
+}
+
+void AVDump_Audio(const int16 *samples, int count)
+{
+	if(!avfile || count <= 0) return;
+
+	AVPacket *p = BeginPush();
+	p->tag = 'A';
+	p->data.assign((const uint8*)samples, (const uint8*)(samples+count));
+	EndPush();
+}
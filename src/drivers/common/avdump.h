@@ -0,0 +1,33 @@
+#ifndef __AVDUMP_H
+#define __AVDUMP_H
+
+#include "../../types.h"
+
+// Native audio/video dump. The emulation thread only copies each frame's
+// palette indices (and audio samples) into a preallocated ring; a worker
+// thread does the delta coding, zlib compression and file I/O.
+//
+// File layout (all integers little endian):
+//   header  "FCXAV\x1A" u16 version, u16 width, u16 height,
+//           u32 fps (8.24 fixed point, as FCEUI_GetDesiredFPS),
+//           u32 sound rate, u16 channels, u16 bits, u32 frame count
+//   packets u8 tag, u32 length, payload
+//     'P'  768 RGB triplets: the 256 driver palette entries followed by the
+//          512 entry deemphasis palette. A pixel maps to entry index, or to
+//          256+(index&0x3F)+deemph*64 when its deemphasis bits are set.
+//     'K'  keyframe: zlib of the 256x240 index plane and 256x240 deemph plane
+//     'D'  delta frame: zlib of both planes XORed with the previous frame
+//     'R'  u32 n: the previous frame is repeated n more times
+//     'A'  signed 16 bit mono samples
+#define AVDUMP_VERSION 1
+
+bool AVDump_Begin(const char *fname, uint32 fps, uint32 soundrate);
+void AVDump_End();
+bool AVDump_Active();
+
+// Queues one 256x240 frame; deemph may be NULL.
+void AVDump_Video(const uint8 *xbuf, const uint8 *deemph);
+// Queues count little endian 16 bit samples.
+void AVDump_Audio(const int16 *samples, int count);
+
+#endif
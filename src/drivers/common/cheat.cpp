@@ -466,6 +466,85 @@ static void DoSearch(void)
  puts("Search completed.\n");
 }
 
+static void RamSearchReset(void)
+{
+ static int size=1,sign=0;
+
+ printf("Value size in bytes (1, 2 or 4) [%d]: ",size);
+ size=GetI(size);
+ printf("Signed values? ");
+ sign=GetYN(sign);
+ int n=FCEUI_RamSearchReset(size,sign!=0);
+ if(n<0)
+ {
+  puts("Invalid size.");
+  size=1;
+ }
+ else
+  printf("%d candidates.\n",n);
+}
+
+static void RamSearchFilter(void)
+{
+ static int method=0,specific=0,value=0;
+ char *m[7]={"Less than",
+   "Greater than",
+   "Less than or equal to",
+   "Greater than or equal to",
+   "Equal to",
+   "Not equal to",
+   "Different by V (C-P==V)"};
+
+ printf("\nCompare current value (C) with previous value (P) or V:\n");
+ method=ShowShortList(m,7,method);
+ if(method!=FCEU_RS_DIFFERENTBY)
+ {
+  printf("Compare with a specific value V instead of P? ");
+  specific=GetYN(specific);
+ }
+ if(specific || method==FCEU_RS_DIFFERENTBY)
+ {
+  printf("V [%d]: ",value);
+  value=GetI(value);
+ }
+ printf("%d candidates left.\n",FCEUI_RamSearchFilter(method,specific!=0,value));
+}
+
+static int rsrescallb(uint32 a, int64 last, int64 current, void *data)
+{
+ char tmp[64];
+ sprintf(tmp, "$%04x:%lld:%lld",(unsigned int)a,(long long)last,(long long)current);
+ return(AddToList(tmp,a));
+}
+
+static void RamSearchShowRes(void)
+{
+ int n=FCEUI_RamSearchGetCount();
+ printf(" %d results:\n",n);
+ if(n)
+ {
+  int which;
+  BeginListShow();
+  FCEUI_RamSearchGet(rsrescallb,0);
+  which=EndListShow();
+  if(which>=0)
+   AddCheatParam(which,0);
+ }
+}
+
+static void RamSearchExclude(void)
+{
+ printf("Address: ");
+ FCEUI_RamSearchExclude(GetH16(0));
+}
+
+static MENU RamSearchMenu[]={
+ {"Reset Search",(void *)RamSearchReset,1},
+ {"Filter",(void *)RamSearchFilter,1},
+ {"Show Results",(void *)RamSearchShowRes,1},
+ {"Exclude Address",(void *)RamSearchExclude,1},
+ {0}
+};
 
 static MENU NewCheatsMenu[]={
  {"Add Cheat",(void *)AddCheat,1},
@@ -476,6 +555,7 @@ static MENU NewCheatsMenu[]={
  {"Show Results",(void *)ShowRes,1},
  {"Add Game Genie Cheat",(void *)AddCheatGG,1},
  {"Add PAR Cheat",(void *)AddCheatPAR,1},
+ {"RAM Search...",(void *)RamSearchMenu,0},
  {0}
 };
 
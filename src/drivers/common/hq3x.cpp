@@ -22,16 +22,8 @@
 #include <stdlib.h>
 
 #include "hq3x.h"
+#include "hqindex.h"
 
-static int   *LUT16to32 = NULL;
-static int   *RGBtoYUV = NULL;
-static int   YUV1, YUV2;
-static const  int   Ymask = 0x00FF0000;
-static const  int   Umask = 0x0000FF00;
-static const  int   Vmask = 0x000000FF;
-static const  int   trY   = 0x00300000;
-static const  int   trU   = 0x00000700;
-static const  int   trV   = 0x00000006;
 
 inline void Interp1(unsigned char * pc, int c1, int c2)
 {
@@ -118,96 +110,65 @@ inline void Interp5(unsigned char * pc, int c1, int c2)
 #define PIXEL22_5   Interp5(pOut+BpL+BpL+8, c[6], c[8]);
 #define PIXEL22_C   *((int*)(pOut+BpL+BpL+8)) = c[5];
 
+// w[] holds palette keys here, see hqindex.h
 static inline int Diff(unsigned int w1, unsigned int w2)
 {
-  YUV1 = RGBtoYUV[w1];
-  YUV2 = RGBtoYUV[w2];
-  return ( ( abs((YUV1 & Ymask) - (YUV2 & Ymask)) > trY ) ||
-           ( abs((YUV1 & Umask) - (YUV2 & Umask)) > trU ) ||
-           ( abs((YUV1 & Vmask) - (YUV2 & Vmask)) > trV ) );
+  return hq_KeyDiffers(w1, w2);
 }
 
-void hq3x_32( unsigned char * pIn, unsigned char * pOut, int Xres, int Yres, int BpL )
+static void hq3x_block(int pattern, const int *w, const int *c, unsigned char *pOut, int BpL);
+
+// Same filter on palette indices, see hq2x_32_index()
+void hq3x_32_index( const unsigned char * src, const unsigned char * srcD, int srcPitch, unsigned char * pOut, int Xres, int Yres, int BpL )
 {
   int  i, j, k;
-  int  prevline, nextline;
   int  w[10];
   int  c[10];
+  int  patterns[HQ_MAX_WIDTH];
+  unsigned short keybuf[3][HQ_MAX_WIDTH+2];
+  unsigned short *prev, *cur, *next;
 
-  //   +----+----+----+
-  //   |    |    |    |
-  //   | w1 | w2 | w3 |
-  //   +----+----+----+
-  //   |    |    |    |
-  //   | w4 | w5 | w6 |
-  //   +----+----+----+
-  //   |    |    |    |
-  //   | w7 | w8 | w9 |
-  //   +----+----+----+
+  cur = keybuf[0] + 1;
+  hq_MakeKeys(src, srcD, cur, Xres);
 
   for (j=0; j<Yres; j++)
   {
-    if (j>0)      prevline = -Xres*2; else prevline = 0;
-    if (j<Yres-1) nextline =  Xres*2; else nextline = 0;
-
-    for (i=0; i<Xres; i++)
+    prev = j>0 ? keybuf[(j+2)%3] + 1 : cur;
+    if (j<Yres-1)
     {
-      int pattern;
-      int flag;
-
-      w[2] = *((unsigned short*)(pIn + prevline));
-      w[5] = *((unsigned short*)pIn);
-      w[8] = *((unsigned short*)(pIn + nextline));
-
-      if (i>0)
-      {
-        w[1] = *((unsigned short*)(pIn + prevline - 2));
-        w[4] = *((unsigned short*)(pIn - 2));
-        w[7] = *((unsigned short*)(pIn + nextline - 2));
-      }
-      else
-      {
-        w[1] = w[2];
-        w[4] = w[5];
-        w[7] = w[8];
-      }
-
-      if (i<Xres-1)
-      {
-        w[3] = *((unsigned short*)(pIn + prevline + 2));
-        w[6] = *((unsigned short*)(pIn + 2));
-        w[9] = *((unsigned short*)(pIn + nextline + 2));
-      }
-      else
-      {
-        w[3] = w[2];
-        w[6] = w[5];
-        w[9] = w[8];
-      }
+      next = keybuf[(j+1)%3] + 1;
+      hq_MakeKeys(src + (j+1)*srcPitch, srcD + (j+1)*srcPitch, next, Xres);
+    }
+    else
+      next = cur;
 
-      pattern = 0;
-      flag = 1;
+    hq_Patterns(prev, cur, next, patterns, Xres);
 
-      YUV1 = RGBtoYUV[w[5]];
+    for (i=0; i<Xres; i++)
+    {
+      const unsigned short key[10] = { 0,
+        prev[i-1], prev[i], prev[i+1],
+        cur[i-1],  cur[i],  cur[i+1],
+        next[i-1], next[i], next[i+1] };
 
       for (k=1; k<=9; k++)
       {
-        if (k==5) continue;
-
-        if ( w[k] != w[5] )
-        {
-          YUV2 = RGBtoYUV[w[k]];
-          if ( ( abs((YUV1 & Ymask) - (YUV2 & Ymask)) > trY ) ||
-               ( abs((YUV1 & Umask) - (YUV2 & Umask)) > trU ) ||
-               ( abs((YUV1 & Vmask) - (YUV2 & Vmask)) > trV ) )
-            pattern |= flag;
-        }
-        flag <<= 1;
+        w[k] = key[k];
+        c[k] = hq_KeyRGB32[key[k]];
       }
 
-      for (k=1; k<=9; k++)
-        c[k] = LUT16to32[w[k]];
+      hq3x_block(patterns[i], w, c, pOut, BpL);
+      pOut+=12;
+    }
+    pOut+=BpL - Xres * 3 * 4;
+    pOut+=BpL;
+    pOut+=BpL;
+    cur = next;
+  }
+}
 
+static void hq3x_block(int pattern, const int *w, const int *c, unsigned char *pOut, int BpL)
+{
       switch (pattern)
       {
         case 0:
@@ -3823,43 +3784,5 @@ void hq3x_32( unsigned char * pIn, unsigned char * pOut, int Xres, int Yres, int
           break;
         }
       }
-      pIn+=2;
-      pOut+=12;
-    }
-    pOut+=BpL - Xres * 3 * 4;
-    pOut+=BpL;
-    pOut+=BpL;
-  }
-}
-
-int hq3x_InitLUTs(void)
-{
-  int i, j, k, r, g, b, Y, u, v;
-
-  if(!(LUT16to32 = (int*)malloc(65536*sizeof(int)))) return(0); //mbg merge 7/17/06 
-  if(!(RGBtoYUV = (int*)malloc(65536*sizeof(int)))) { free(LUT16to32); return(0); } //mbg merge 7/17/06 
-
-  for (i=0; i<65536; i++)
-    LUT16to32[i] = ((i & 0xF800) << 8) + ((i & 0x07E0) << 5) + ((i & 0x001F) << 3);
-
-  for (i=0; i<32; i++)
-  for (j=0; j<64; j++)
-  for (k=0; k<32; k++)
-  {
-    r = i << 3;
-    g = j << 2;
-    b = k << 3;
-    Y = (r + g + b) >> 2;
-    u = 128 + ((r - b) >> 2);
-    v = 128 + ((-r + 2*g -b)>>3);
-    RGBtoYUV[ (i << 11) + (j << 5) + k ] = (Y<<16) + (u<<8) + v;
-  }
- return(1);
-}
-
-void hq3x_Kill(void)
-{
- free(LUT16to32);
- free(RGBtoYUV);
 }
 
@@ -1,4 +1,2 @@
-void hq3x_32( unsigned char * pIn, unsigned char * pOut, int Xres, int Yres, int BpL);
-int hq3x_InitLUTs(void);
-void hq3x_Kill(void);
+void hq3x_32_index( const unsigned char * src, const unsigned char * srcD, int srcPitch, unsigned char * pOut, int Xres, int Yres, int BpL);
 
@@ -0,0 +1,116 @@
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+#include "hqindex.h"
+
+int hq_KeyRGB32[HQ_KEYS];
+unsigned int hq_KeyDiff[HQ_KEYS][HQ_KEYS/32];
+
+static const int Ymask = 0x00FF0000;
+static const int Umask = 0x0000FF00;
+static const int Vmask = 0x000000FF;
+static const int trY   = 0x00300000;
+static const int trU   = 0x00000700;
+static const int trV   = 0x00000006;
+
+// Same conversion as the RGBtoYUV tables in hq2x.cpp/hq3x.cpp
+static int RGB16toYUV(int c)
+{
+	int r = ((c >> 11) & 0x1F) << 3;
+	int g = ((c >> 5) & 0x3F) << 2;
+	int b = (c & 0x1F) << 3;
+	int Y = (r + g + b) >> 2;
+	int u = 128 + ((r - b) >> 2);
+	int v = 128 + ((-r + 2*g - b) >> 3);
+	return (Y << 16) + (u << 8) + v;
+}
+
+void hq_SetPalette(const unsigned int *rgb16)
+{
+	int yuv[HQ_KEYS];
+
+	for(int i = 0; i < HQ_KEYS; i++)
+	{
+		int c = rgb16[i] & 0xFFFF;
+		hq_KeyRGB32[i] = ((c & 0xF800) << 8) + ((c & 0x07E0) << 5) + ((c & 0x001F) << 3);
+		yuv[i] = RGB16toYUV(c);
+	}
+
+	// the test is symmetric, so only half the pairs need evaluating
+	memset(hq_KeyDiff, 0, sizeof(hq_KeyDiff));
+	for(int a = 0; a < HQ_KEYS; a++)
+		for(int b = a + 1; b < HQ_KEYS; b++)
+		{
+			if(( abs((yuv[a] & Ymask) - (yuv[b] & Ymask)) > trY ) ||
+			   ( abs((yuv[a] & Umask) - (yuv[b] & Umask)) > trU ) ||
+			   ( abs((yuv[a] & Vmask) - (yuv[b] & Vmask)) > trV ))
+			{
+				hq_KeyDiff[a][b >> 5] |= 1u << (b & 31);
+				hq_KeyDiff[b][a >> 5] |= 1u << (a & 31);
+			}
+		}
+}
+
+void hq_MakeKeys(const unsigned char *src, const unsigned char *deemph, unsigned short *keys, int n)
+{
+	for(int i = 0; i < n; i++)
+	{
+		int d = deemph[i];
+		keys[i] = d ? 256 + (src[i] & 0x3F) + d*64 : src[i];
+	}
+	keys[-1] = keys[0];
+	keys[n] = keys[n-1];
+}
+
+static inline int Differs(const unsigned int *row, int k)
+{
+	return (row[k >> 5] >> (k & 31)) & 1;
+}
+
+static inline int PatternAt(const unsigned short *prev, const unsigned short *cur, const unsigned short *next, int i)
+{
+	const unsigned int *row = hq_KeyDiff[cur[i]];
+
+	return Differs(row, prev[i-1])
+	     | Differs(row, prev[i])   << 1
+	     | Differs(row, prev[i+1]) << 2
+	     | Differs(row, cur[i-1])  << 3
+	     | Differs(row, cur[i+1])  << 4
+	     | Differs(row, next[i-1]) << 5
+	     | Differs(row, next[i])   << 6
+	     | Differs(row, next[i+1]) << 7;
+}
+
+void hq_Patterns(const unsigned short *prev, const unsigned short *cur, const unsigned short *next, int *patterns, int n)
+{
+	int i = 0;
+
+#ifdef __SSE2__
+	// Flat areas are the common case: when all eight neighbours carry the
+	// same key as the centre pixel the pattern is 0 and the table lookups
+	// can be skipped. The arrays are padded by one key on both sides.
+	for(; i + 8 <= n; i += 8)
+	{
+		__m128i c = _mm_loadu_si128((const __m128i*)(cur + i));
+		__m128i eq = _mm_and_si128(_mm_cmpeq_epi16(c, _mm_loadu_si128((const __m128i*)(cur + i - 1))),
+		                           _mm_cmpeq_epi16(c, _mm_loadu_si128((const __m128i*)(cur + i + 1))));
+		eq = _mm_and_si128(eq, _mm_cmpeq_epi16(c, _mm_loadu_si128((const __m128i*)(prev + i - 1))));
+		eq = _mm_and_si128(eq, _mm_cmpeq_epi16(c, _mm_loadu_si128((const __m128i*)(prev + i))));
+		eq = _mm_and_si128(eq, _mm_cmpeq_epi16(c, _mm_loadu_si128((const __m128i*)(prev + i + 1))));
+		eq = _mm_and_si128(eq, _mm_cmpeq_epi16(c, _mm_loadu_si128((const __m128i*)(next + i - 1))));
+		eq = _mm_and_si128(eq, _mm_cmpeq_epi16(c, _mm_loadu_si128((const __m128i*)(next + i))));
+		eq = _mm_and_si128(eq, _mm_cmpeq_epi16(c, _mm_loadu_si128((const __m128i*)(next + i + 1))));
+
+		int flat = _mm_movemask_epi8(eq);
+		for(int k = 0; k < 8; k++)
+			patterns[i + k] = ((flat >> (k*2)) & 1) ? 0 : PatternAt(prev, cur, next, i + k);
+	}
+#endif
+
+	for(; i < n; i++)
+		patterns[i] = PatternAt(prev, cur, next, i);
+}
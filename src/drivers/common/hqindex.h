@@ -0,0 +1,29 @@
+#ifndef __HQINDEX_H
+#define __HQINDEX_H
+
+// Palette-index front end for hq2x/hq3x. A key is the palette entry a pixel
+// finally maps to: the XBuf index itself, or 256+(index&0x3F)+deemph*64 for
+// pixels with emphasis bits set (the same lookup ModernDeemphColorMap does).
+#define HQ_KEYS      768
+#define HQ_MAX_WIDTH 256
+
+extern int hq_KeyRGB32[HQ_KEYS];
+
+// Bit k of hq_KeyDiff[a] is set when keys a and k fail the hq YUV threshold test.
+extern unsigned int hq_KeyDiff[HQ_KEYS][HQ_KEYS/32];
+
+static inline int hq_KeyDiffers(int a, int b)
+{
+	return (hq_KeyDiff[a][b >> 5] >> (b & 31)) & 1;
+}
+
+// Rebuilds the tables from a 768 entry RGB565 palette. Must be called whenever the palette changes.
+void hq_SetPalette(const unsigned int *rgb16);
+
+// Converts n pixels to keys. keys[-1] and keys[n] are filled with copies of the edge pixels.
+void hq_MakeKeys(const unsigned char *src, const unsigned char *deemph, unsigned short *keys, int n);
+
+// Computes the 8-bit hq neighbour pattern for each pixel of cur.
+void hq_Patterns(const unsigned short *prev, const unsigned short *cur, const unsigned short *next, int *patterns, int n);
+
+#endif
@@ -5,6 +5,10 @@
 
 #include "nes_ntsc.h"
 
+#if defined (__SSE2__)
+	#include <emmintrin.h>
+#endif
+
 /* Copyright (C) 2006-2007 Shay Green. This module is free software; you
 can redistribute it and/or modify it under the terms of the GNU Lesser
 General Public License as published by the Free Software Foundation; either
@@ -85,6 +89,7 @@ void nes_ntsc_init( nes_ntsc_t* ntsc, nes_ntsc_setup_t const* setup, int bpp )
 {
 	int merge_fields;
 	int entry;
+	int n;
 	init_t impl;
 	float gamma_factor;
 
@@ -234,6 +239,8 @@ void nes_ntsc_init( nes_ntsc_t* ntsc, nes_ntsc_setup_t const* setup, int bpp )
 					if ( merge_fields )
 						merge_kernel_fields( kernel );
 					correct_errors( rgb, kernel );
+					for ( n = 0; n < nes_ntsc_entry_size; n++ )
+						ntsc->table32 [entry] [n] = (unsigned int) kernel [n];
 				}
 			}
 		}
@@ -242,11 +249,121 @@ void nes_ntsc_init( nes_ntsc_t* ntsc, nes_ntsc_setup_t const* setup, int bpp )
 
 #ifndef NES_NTSC_NO_BLITTERS
 
+#if defined (__SSE2__)
+
+/* CUSTOM: SIMD version of one blitter row, 32-bit output only. The seven outputs
+of a chunk are summed side by side from table32 instead of one after another. */
+
+#define NES_NTSC_ENTRY32_( n ) \
+	((unsigned int const*) (ktable32 + (n) * (nes_ntsc_entry_size * sizeof (unsigned int))))
+
+/* two kernel entries at p [a], p [a + 1] in the low half and q [b], q [b + 1] in the high half */
+#define NES_NTSC_PAIRS_( p, a, q, b ) \
+	_mm_unpacklo_epi64( _mm_loadl_epi64( (__m128i const*) ((p) + (a)) ),\
+			_mm_loadl_epi64( (__m128i const*) ((q) + (b)) ) )
+
+static __m128i nes_ntsc_clamp_out( __m128i raw )
+{
+	__m128i sub   = _mm_and_si128( _mm_srli_epi32( raw, 9 ), _mm_set1_epi32( nes_ntsc_clamp_mask ) );
+	__m128i clamp = _mm_sub_epi32( _mm_set1_epi32( nes_ntsc_clamp_add ), sub );
+	raw   = _mm_or_si128( raw, clamp );
+	clamp = _mm_sub_epi32( clamp, sub );
+	raw   = _mm_and_si128( raw, clamp );
+	return _mm_or_si128( _mm_or_si128(
+			_mm_and_si128( _mm_srli_epi32( raw, 5 ), _mm_set1_epi32( 0xFF0000 ) ),
+			_mm_and_si128( _mm_srli_epi32( raw, 3 ), _mm_set1_epi32( 0xFF00 ) ) ),
+			_mm_and_si128( _mm_srli_epi32( raw, 1 ), _mm_set1_epi32( 0xFF ) ) );
+}
+
+static void nes_ntsc_blit_row_simd( nes_ntsc_t const* ntsc, NES_NTSC_IN_T const* line_in,
+		NES_NTSC_IN_T const* line_inD, int burst_phase, int chunk_count, nes_ntsc_out_t* line_out )
+{
+	char const* const ktable32 =
+		(char const*) ntsc->table32 [0] + burst_phase * (nes_ntsc_burst_size * sizeof (unsigned int));
+	/* same start as NES_NTSC_BEGIN_ROW, kernelx0 is always the previous kernel0 */
+	unsigned int const* kernel0  = NES_NTSC_ENTRY32_( nes_ntsc_black );
+	unsigned int const* kernel1  = NES_NTSC_ENTRY32_( nes_ntsc_black );
+	unsigned int const* kernel2  = NES_NTSC_ENTRY32_( NES_NTSC_ADJ_IN( *line_in, *line_inD ) );
+	unsigned int const* kernelx1 = kernel0;
+	unsigned int const* kernelx2 = kernel0;
+	int n;
+	++line_in;
+
+	for ( n = chunk_count + 1; n; --n )
+	{
+		unsigned int const* new0;
+		unsigned int const* new1;
+		unsigned int const* new2;
+		__m128i lo, hi;
+
+		if ( n > 1 )
+		{
+			new0 = NES_NTSC_ENTRY32_( NES_NTSC_ADJ_IN( line_in [0], line_inD [0] ) );
+			new1 = NES_NTSC_ENTRY32_( NES_NTSC_ADJ_IN( line_in [1], line_inD [1] ) );
+			new2 = NES_NTSC_ENTRY32_( NES_NTSC_ADJ_IN( line_in [2], line_inD [2] ) );
+		}
+		else
+		{
+			/* finish final pixels */
+			new0 = new1 = new2 = NES_NTSC_ENTRY32_( nes_ntsc_black );
+		}
+
+		/* outputs 0 and 1 come before the second color in, 2 and 3 before the third */
+		lo = _mm_add_epi32( _mm_loadu_si128( (__m128i const*) new0 ),
+				NES_NTSC_PAIRS_( kernel1, 19, new1, 14 ) );
+		lo = _mm_add_epi32( lo, NES_NTSC_PAIRS_( kernel2, 31, kernel2, 33 ) );
+		lo = _mm_add_epi32( lo, _mm_loadu_si128( (__m128i const*) (kernel0 + 7) ) );
+		lo = _mm_add_epi32( lo, NES_NTSC_PAIRS_( kernelx1, 26, kernel1, 21 ) );
+		lo = _mm_add_epi32( lo, _mm_loadu_si128( (__m128i const*) (kernelx2 + 38) ) );
+
+		/* outputs 4 to 6, the fourth lane is not stored */
+		hi = _mm_add_epi32( _mm_loadu_si128( (__m128i const*) (new0 + 4) ),
+				_mm_loadu_si128( (__m128i const*) (new1 + 16) ) );
+		hi = _mm_add_epi32( hi, _mm_loadu_si128( (__m128i const*) (new2 + 28) ) );
+		hi = _mm_add_epi32( hi, _mm_loadu_si128( (__m128i const*) (kernel0 + 11) ) );
+		hi = _mm_add_epi32( hi, _mm_loadu_si128( (__m128i const*) (kernel1 + 23) ) );
+		hi = _mm_add_epi32( hi, _mm_loadu_si128( (__m128i const*) (kernel2 + 35) ) );
+
+		lo = nes_ntsc_clamp_out( lo );
+		hi = nes_ntsc_clamp_out( hi );
+		_mm_storeu_si128( (__m128i*) line_out, lo );
+		_mm_storel_epi64( (__m128i*) (line_out + 4), hi );
+		line_out [6] = (nes_ntsc_out_t) _mm_cvtsi128_si32( _mm_srli_si128( hi, 8 ) );
+
+		kernelx1 = kernel1;
+		kernelx2 = kernel2;
+		kernel0 = new0;
+		kernel1 = new1;
+		kernel2 = new2;
+
+		line_in  += 3;
+		line_inD += 3;
+		line_out += rescale_out;
+	}
+}
+
+#endif
+
 void nes_ntsc_blit( nes_ntsc_t const* ntsc, NES_NTSC_IN_T const* input, NES_NTSC_IN_T const* inputD, long in_row_width,
 		int burst_phase, int in_width, int in_height, void* rgb_out, long out_pitch )
 {
 	int chunk_count = (in_width - 1) / nes_ntsc_in_chunk;
 
+#if defined (__SSE2__)
+	if ( OutputDepth == 32 || OutputDepth == 24 )
+	{
+		for ( ; in_height; --in_height )
+		{
+			nes_ntsc_blit_row_simd( ntsc, input, inputD, burst_phase, chunk_count, (nes_ntsc_out_t*) rgb_out );
+			rgb_out = (char*) rgb_out + out_pitch;
+			burst_phase = (burst_phase + 1) % nes_ntsc_burst_count;
+			input += in_row_width;
+			inputD += in_row_width;
+		}
+		return;
+	}
+#endif
+
 	for ( ; in_height; --in_height )
 	{
 		NES_NTSC_IN_T const* line_in = input;
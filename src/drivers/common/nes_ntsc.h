@@ -111,6 +111,9 @@ enum { nes_ntsc_entry_size = 128 };
 typedef unsigned long nes_ntsc_rgb_t;
 struct nes_ntsc_t {
 	nes_ntsc_rgb_t table [nes_ntsc_palette_size] [nes_ntsc_entry_size];
+	/* CUSTOM: table truncated to 32 bits for the SIMD blitter. The output only
+	depends on the low 32 bits of the kernel sums, so it matches the scalar one. */
+	unsigned int table32 [nes_ntsc_palette_size] [nes_ntsc_entry_size];
 };
 enum { nes_ntsc_burst_size = nes_ntsc_entry_size / nes_ntsc_burst_count };
 
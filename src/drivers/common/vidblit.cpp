@@ -19,10 +19,21 @@
  */
 
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#ifdef __AVX2__
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 #include "scalebit.h"
 #include "hq2x.h"
 #include "hq3x.h"
+#include "hqindex.h"
 
 #include "../../fceu.h"
 #include "../../types.h"
@@ -41,15 +52,114 @@ extern pal *palo;
 nes_ntsc_t* nes_ntsc;
 uint8 burst_phase = 0;
 
+// The ntsc filter splits the frame into row bands on these threads. A row only
+// depends on its own burst phase, so every band is blitted on its own.
+static struct
+{
+	std::vector<std::thread> threads;
+	std::mutex mutex;
+	std::condition_variable wake, done;
+	unsigned generation;
+	int pending;
+	bool quit;
+
+	// the frame being blitted
+	const uint8 *src, *srcD;
+	int xr, yr, phase;
+	uint8 *out;
+	long pitch;
+} ntscpool;
+
+static void NTSCBlitBand(int band, int bands)
+{
+	int first = ntscpool.yr * band / bands;
+	int last = ntscpool.yr * (band + 1) / bands;
+	if(first == last)
+		return;
+	nes_ntsc_blit(nes_ntsc, (unsigned char*)ntscpool.src + first*ntscpool.xr, (unsigned char*)ntscpool.srcD + first*ntscpool.xr, ntscpool.xr,
+		(ntscpool.phase + first) % nes_ntsc_burst_count, ntscpool.xr, last - first,
+		ntscpool.out + first*ntscpool.pitch, ntscpool.pitch);
+}
+
+static void NTSCWorker(int band)
+{
+	unsigned seen = 0;
+	for(;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(ntscpool.mutex);
+			ntscpool.wake.wait(lock, [&]{ return ntscpool.quit || ntscpool.generation != seen; });
+			if(ntscpool.quit)
+				return;
+			seen = ntscpool.generation;
+		}
+		NTSCBlitBand(band, ntscpool.threads.size() + 1);
+		std::lock_guard<std::mutex> lock(ntscpool.mutex);
+		if(--ntscpool.pending == 0)
+			ntscpool.done.notify_one();
+	}
+}
+
+static void NTSCStartPool(void)
+{
+	int bands = std::thread::hardware_concurrency();
+	if(bands > 4)
+		bands = 4;
+	ntscpool.quit = false;
+	ntscpool.generation = 0;
+	for(int band = 1; band < bands; band++)
+		ntscpool.threads.push_back(std::thread(NTSCWorker, band));
+}
+
+static void NTSCStopPool(void)
+{
+	{
+		std::lock_guard<std::mutex> lock(ntscpool.mutex);
+		ntscpool.quit = true;
+	}
+	ntscpool.wake.notify_all();
+	for(size_t i = 0; i < ntscpool.threads.size(); i++)
+		ntscpool.threads[i].join();
+	ntscpool.threads.clear();
+}
+
+// nes_ntsc_blit with rows xr apart, the calling thread takes the first band
+static void NTSCBlit(const uint8 *src, const uint8 *srcD, int xr, int yr, int phase, uint8 *out, long pitch)
+{
+	ntscpool.src = src;
+	ntscpool.srcD = srcD;
+	ntscpool.xr = xr;
+	ntscpool.yr = yr;
+	ntscpool.phase = phase;
+	ntscpool.out = out;
+	ntscpool.pitch = pitch;
+
+	int bands = ntscpool.threads.size() + 1;
+	if(bands > 1)
+	{
+		std::lock_guard<std::mutex> lock(ntscpool.mutex);
+		ntscpool.pending = bands - 1;
+		ntscpool.generation++;
+	}
+	ntscpool.wake.notify_all();
+	NTSCBlitBand(0, bands);
+	if(bands > 1)
+	{
+		std::unique_lock<std::mutex> lock(ntscpool.mutex);
+		ntscpool.done.wait(lock, []{ return ntscpool.pending == 0; });
+	}
+}
+
 static uint32 CBM[3];
 static uint32 *palettetranslate=0;
+static uint32 *deemphlut=0;	// palettetranslate resolved for every deemph level, indexed by deemph<<8|pixel
 static int backBpp, backshiftr[3], backshiftl[3];
 static int silt;
 static int Bpp;	// BYTES per pixel
 static int highefx;
 //static uint32 backmask[3];
 
-static uint16 *specbuf=NULL;		// 8bpp -> 16bpp, pre hq2x/hq3x
+static bool hqfilter=false;		// hq2x/hq3x, filtered straight from XBuf/XDBuf
 static uint32 *specbuf32bpp= NULL;	// Buffer to hold output of hq2x/hq3x when converting to 16bpp and 24bpp
 static uint8  *specbuf8bpp = NULL;	// For 2xscale, 3xscale.
 static uint8  *ntscblit    = NULL;	// For nes_ntsc
@@ -137,6 +247,7 @@ int InitBlitToHigh(int b, uint32 rmask, uint32 gmask, uint32 bmask, int efx, int
 		{
 			nes_ntsc_init( nes_ntsc, &ntsc_setup, b );			
 			ntscblit = (uint8*)FCEU_dmalloc(602*257*b);
+			NTSCStartPool();
 		}
 		
 	} // -Video Modes Tag-
@@ -190,13 +301,7 @@ int InitBlitToHigh(int b, uint32 rmask, uint32 gmask, uint32 bmask, int efx, int
 		gmask=0x3F<<5;
 		bmask=0x1F;
 		
-		// -Video Modes Tag-
-		if(specfilt == 4)
-			hq3x_InitLUTs();
-		else
-			hq2x_InitLUTs();
-		
-		specbuf=(uint16*)FCEU_dmalloc(256*240*sizeof(uint16)); //mbg merge 7/17/06 added cast
+		hqfilter=true;
 	}
 	else if (specfilt >= 6 && specfilt <= 8)
 	{
@@ -219,8 +324,9 @@ int InitBlitToHigh(int b, uint32 rmask, uint32 gmask, uint32 bmask, int efx, int
 	
 	//allocate adequate room for 32bpp palette
 	palettetranslate=(uint32*)FCEU_dmalloc(256*4 + 512*4);
+	deemphlut=(uint32*)FCEU_dmalloc(8*256*4);
 	
-	if(!palettetranslate)
+	if(!palettetranslate || !deemphlut)
 		return(0);
 	
 	
@@ -237,6 +343,11 @@ void KillBlitToHigh(void)
 		free(palettetranslate);
 		palettetranslate=NULL;
 	}
+	if(deemphlut)
+	{
+		free(deemphlut);
+		deemphlut=NULL;
+	}
 	
 	if(specbuf8bpp)
 	{
@@ -248,16 +359,9 @@ void KillBlitToHigh(void)
 		free(specbuf32bpp);
 		specbuf32bpp = NULL;
 	}
-	if(specbuf)
-	{
-	// -Video Modes Tag-
-		if(silt == 4)
-			hq3x_Kill();
-		else
-			hq2x_Kill();
-		specbuf=NULL;
-	}
+	hqfilter=false;
 	if (nes_ntsc) {
+		NTSCStopPool();
 		free(nes_ntsc);
 		nes_ntsc = NULL;
 	}
@@ -316,6 +420,9 @@ void SetPaletteBlitToHigh(uint8 *src)
 			}
 		}
 
+		if(hqfilter)
+			hq_SetPalette(palettetranslate);
+
 		break;
 
 	case 3:
@@ -342,6 +449,12 @@ void SetPaletteBlitToHigh(uint8 *src)
 
 		break;
 	}
+
+	// one lookup per output pixel: deemph level 0 keeps the whole 8-bit XBuf value
+	// (gui colors live above $3F), the others use the deemph palette
+	for(int d=0;d<8;d++)
+		for(int x=0;x<256;x++)
+			deemphlut[(d<<8)|x] = (d && palo) ? palettetranslate[256+(x&0x3F)+d*64] : palettetranslate[x];
 }
 
 void Blit32to24(uint32 *src, uint8 *dest, int xr, int yr, int dpitch)
@@ -463,11 +576,6 @@ void Blit8To8(uint8 *src, uint8 *dest, int xr, int yr, int pitch, int xscale, in
 //takes a pointer to XBuf and applies fully modern deemph palettizing
 u32 ModernDeemphColorMap(u8* src, u8* srcbuf, int xscale, int yscale)
 {
-	u8 pixel = *src;
-	
-	//look up the legacy translation
-	u32 color = palettetranslate[pixel];
-
 	int ofs = src-srcbuf;
 	int xofs = ofs&255;
 	int yofs = ofs>>8;
@@ -476,21 +584,89 @@ u32 ModernDeemphColorMap(u8* src, u8* srcbuf, int xscale, int yscale)
 	ofs = xofs+yofs*256;
 
 	//find out which deemph bitplane value we're on
-	uint8 deemph = XDBuf[ofs];
+	return deemphlut[(XDBuf[ofs]<<8)|*src];
+}
 
-	//if it was a deemph'd value, grab it from the deemph palette
-	if(deemph != 0)
-		color = palettetranslate[256+(pixel&0x3F)+deemph*64];
+//converts one line of XBuf (with its deemph line) through deemphlut, repeating each pixel xscale (1-4) times.
+//the plain blits spend all their time here, so keep it free of calls and branches per pixel
+static void BlitLine32(const uint8 *src, const uint8 *deemph, uint32 *dest, int xr, int xscale)
+{
+	const uint32 *lut = deemphlut;
+	int x = 0;
+
+#ifdef __SSE2__
+	for(; xscale <= 4 && x+4 <= xr; x+=4, dest+=4*xscale)
+	{
+#ifdef __AVX2__
+		__m128i idx = _mm_or_si128(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(*(const int *)(src+x))),
+		                           _mm_slli_epi32(_mm_cvtepu8_epi32(_mm_cvtsi32_si128(*(const int *)(deemph+x))), 8));
+		__m128i c = _mm_i32gather_epi32((const int *)lut, idx, 4);
+#else
+		__m128i c = _mm_set_epi32(lut[(deemph[x+3]<<8)|src[x+3]], lut[(deemph[x+2]<<8)|src[x+2]],
+		                          lut[(deemph[x+1]<<8)|src[x+1]], lut[(deemph[x]<<8)|src[x]]);
+#endif
+		__m128i *d = (__m128i *)dest;
+		switch(xscale)
+		{
+		case 1:
+			_mm_storeu_si128(d, c);
+			break;
+		case 2:
+			_mm_storeu_si128(d,   _mm_unpacklo_epi32(c, c));
+			_mm_storeu_si128(d+1, _mm_unpackhi_epi32(c, c));
+			break;
+		case 3:
+			_mm_storeu_si128(d,   _mm_shuffle_epi32(c, _MM_SHUFFLE(1,0,0,0)));
+			_mm_storeu_si128(d+1, _mm_shuffle_epi32(c, _MM_SHUFFLE(2,2,1,1)));
+			_mm_storeu_si128(d+2, _mm_shuffle_epi32(c, _MM_SHUFFLE(3,3,3,2)));
+			break;
+		default:
+			_mm_storeu_si128(d,   _mm_shuffle_epi32(c, _MM_SHUFFLE(0,0,0,0)));
+			_mm_storeu_si128(d+1, _mm_shuffle_epi32(c, _MM_SHUFFLE(1,1,1,1)));
+			_mm_storeu_si128(d+2, _mm_shuffle_epi32(c, _MM_SHUFFLE(2,2,2,2)));
+			_mm_storeu_si128(d+3, _mm_shuffle_epi32(c, _MM_SHUFFLE(3,3,3,3)));
+			break;
+		}
+	}
+#endif
+
+	for(; x < xr; x++)
+	{
+		uint32 color = lut[(deemph[x]<<8)|src[x]];
+		for(int too=xscale; too; too--)
+			*dest++ = color;
+	}
+}
+
+static void BlitLine24(const uint8 *src, const uint8 *deemph, uint8 *dest, int xr, int xscale)
+{
+	for(int x=0; x<xr; x++)
+	{
+		uint32 color = deemphlut[(deemph[x]<<8)|src[x]];
+		for(int too=xscale; too; too--, dest+=3)
+		{
+			dest[0] = color;
+			dest[1] = color>>8;
+			dest[2] = color>>16;
+		}
+	}
+}
 
-	return color;
+static void BlitLine16(const uint8 *src, const uint8 *deemph, uint16 *dest, int xr, int xscale)
+{
+	for(int x=0; x<xr; x++)
+	{
+		uint16 color = deemphlut[(deemph[x]<<8)|src[x]];
+		for(int too=xscale; too; too--)
+			*dest++ = color;
+	}
 }
 
 void Blit8ToHigh(uint8 *src, uint8 *dest, int xr, int yr, int pitch, int xscale, int yscale)
 {
 	int x,y;
 	int pinc;
-	uint8 *destbackup = NULL;	/* For hq2x */
-	int pitchbackup = 0;
+	uint8 *destbackup = NULL;	/* For prescale */
 
 	
 	//static int google=0;
@@ -568,20 +744,10 @@ void Blit8ToHigh(uint8 *src, uint8 *dest, int xr, int yr, int pitch, int xscale,
 	{
 		destbackup = dest;
 		dest = (uint8 *)prescalebuf;
-		pitchbackup = pitch;		
 		pitch = xr*sizeof(uint32);
-		pinc = pitch-(xr<<2);
 
-		for(y=yr; y; y--, src+=256-xr)
-		{
-			for(x=xr; x; x--)
-			{
-				*(uint32 *)dest = ModernDeemphColorMap(src,XBuf,1,1);
-				dest += 4;
-				src++;
-			}
-			dest += pinc;
-		}
+		for(y=yr; y; y--, src+=256, dest+=pitch)
+			BlitLine32(src, XDBuf+(src-XBuf), (uint32 *)dest, xr, 1);
 
 		if (Bpp == 4) // are other modes really needed?
 		{
@@ -790,193 +956,141 @@ void Blit8ToHigh(uint8 *src, uint8 *dest, int xr, int yr, int pitch, int xscale,
 		}
 		return;
 	}
-	else if(specbuf)                 // hq2x/hq3x
+	else if(hqfilter)                // hq2x/hq3x
 	{
-		destbackup=dest;
-		dest=(uint8 *)specbuf;
-		pitchbackup=pitch;
-		
-		pitch=xr*sizeof(uint16);
-		xscale=1;
-		yscale=1;
+		// -Video Modes Tag-
+		int mult = (silt == 4)?3:2;
+		uint8 *out = specbuf32bpp ? (uint8 *)specbuf32bpp : dest;
+		int outpitch = specbuf32bpp ? xr*mult*sizeof(uint32) : pitch;
+
+		if(silt == 4)
+			hq3x_32_index(src,XDBuf+(src-XBuf),256,out,xr,yr,outpitch);
+		else
+			hq2x_32_index(src,XDBuf+(src-XBuf),256,out,xr,yr,outpitch);
+
+		if(specbuf32bpp)
+		{
+			if(backBpp == 2)
+				Blit32to16(specbuf32bpp, (uint16*)dest, xr*mult, yr*mult, pitch, backshiftr,backshiftl);
+			else // == 3
+				Blit32to24(specbuf32bpp, dest, xr*mult, yr*mult, pitch);
+		}
+		return;
 	}
 	
+	if(nes_ntsc && Bpp == 4 && (xscale!=1 || yscale!=1) && GameInfo && GameInfo->type!=GIT_NSF)
 	{
-		if(xscale!=1 || yscale!=1)
+		int outxr = 301;
+		//if(xr == 282) outxr = 282; //hack for windows
+		burst_phase ^= 1;
+
+		u8* srcD = XDBuf + (src-XBuf); // get deemphasis buffer
+		NTSCBlit( src, srcD, xr, yr, burst_phase, ntscblit, (2*outxr) * Bpp );
+
+		const uint8 *in = ntscblit + (Bpp * xscale);
+		uint8 *out = dest;
+		const int in_stride = Bpp * outxr * 2;
+		const int out_stride = pitch;
+		for( int y = 0; y < yr; y++, in += in_stride, out += 2*out_stride ) {
+			memcpy(out, in, Bpp * outxr * xscale);
+			memcpy(out + out_stride, in, Bpp * outxr * xscale);
+		}
+		return;
+	}
+
+	//plain integer scaling, vertical by repeating the converted line
+	{
+		int rowbytes = xr*xscale*Bpp;
+
+		for(y=yr;y;y--,src+=256)
 		{
+			const uint8 *srcD = XDBuf+(src-XBuf);
+
 			switch(Bpp)
 			{
 			case 4:
-				if ( nes_ntsc && GameInfo && GameInfo->type!=GIT_NSF) {
-					int outxr = 301;
-					//if(xr == 282) outxr = 282; //hack for windows
-					burst_phase ^= 1;
-
-					u8* srcD = XDBuf + (src-XBuf); // get deemphasis buffer
-					nes_ntsc_blit( nes_ntsc, (unsigned char*)src, (unsigned char*)srcD, xr, burst_phase, xr, yr, ntscblit, (2*outxr) * Bpp );
-
-					const uint8 *in = ntscblit + (Bpp * xscale);
-					uint8 *out = dest;
-					const int in_stride = Bpp * outxr * 2;
-					const int out_stride = pitch;
-					for( int y = 0; y < yr; y++, in += in_stride, out += 2*out_stride ) {
-						memcpy(out, in, Bpp * outxr * xscale);
-						memcpy(out + out_stride, in, Bpp * outxr * xscale);
-					}
-				} else {
-					pinc=pitch-((xr*xscale)<<2);
-					for(y=yr;y;y--,src+=256-xr)
-					{
-						int doo=yscale;
-						        
-						do
-						{
-							for(x=xr;x;x--,src++)
-							{
-								int too=xscale;
-								do
-								{
-									*(uint32 *)dest=palettetranslate[*src];
-									dest+=4;
-								} while(--too);
-							}
-							src-=xr;
-							dest+=pinc;
-						} while(--doo);
-						src+=xr;
-					}
-				}
+				//THE MAIN BLITTING CODEPATH (there may be others that are important)
+				BlitLine32(src, srcD, (uint32 *)dest, xr, xscale);
 				break;
-			
 			case 3:
-				pinc=pitch-((xr*xscale)*3);
-				for(y=yr;y;y--,src+=256-xr)
-				{  
-					int doo=yscale;
-					 
-					do
-					{
-						for(x=xr;x;x--,src++)
-						{    
-							int too=xscale;
-							do
-							{
-								uint32 tmp=palettetranslate[(uint32)*src];
-								*(uint8 *)dest=tmp;
-								*((uint8 *)dest+1)=tmp>>8;
-								*((uint8 *)dest+2)=tmp>>16;
-								dest+=3;
-								
-								//*(uint32 *)dest=palettetranslate[*src];
-								//dest+=4;
-							} while(--too);
-						}
-						src-=xr;
-						dest+=pinc;
-					} while(--doo);
-					src+=xr;
-				}
+				BlitLine24(src, srcD, dest, xr, xscale);
 				break;
-						
 			case 2:
-				pinc=pitch-((xr*xscale)<<1);
-				   
-				for(y=yr;y;y--,src+=256-xr)
-				{   
-					int doo=yscale;
-					   
-					do
-					{
-						for(x=xr;x;x--,src++)
-						{
-							int too=xscale;
-							do
-							{
-								//*(uint16 *)dest=palettetranslate[*src]; 16bpp is doomed right now
-								dest+=2;
-							} while(--too);
-						}
-					src-=xr;
-					dest+=pinc;
-					} while(--doo);
-					src+=xr;
-				}  
+				BlitLine16(src, srcD, (uint16 *)dest, xr, xscale);
 				break;
 			}
+			for(int doo=1;doo<yscale;doo++)
+				memcpy(dest+doo*pitch, dest, rowbytes);
+			dest+=pitch*yscale;
 		}
-		else
-			switch(Bpp)
+	}
+}
+
+/* Blends a 256x240 B,G,R,A overlay (the Lua GUI canvas) over a frame that
+ * Blit8ToHigh produced without a special filter. xofs/yofs are the first
+ * XBuf column/line that was blitted to dest; only the rows in
+ * firstline..lastline and the columns in spanleft[y]..spanright[y] are visited.
+ */
+void BlitOverlayToHigh(const uint8 *overlay, int firstline, int lastline, const int *spanleft, const int *spanright,
+                       int xofs, int yofs, uint8 *dest, int xr, int yr, int pitch, int xscale, int yscale)
+{
+	int cshiftr[3];
+	int cshiftl[3];
+
+	if(Bpp != 3 && Bpp != 4)
+		return;
+
+	CalculateShift(CBM, cshiftr, cshiftl);
+
+	if(firstline < yofs)
+		firstline = yofs;
+	if(lastline > yofs + yr - 1)
+		lastline = yofs + yr - 1;
+
+	for(int y = firstline; y <= lastline; y++)
+	{
+		int x1 = spanleft[y] < xofs ? xofs : spanleft[y];
+		int x2 = spanright[y] > xofs + xr - 1 ? xofs + xr - 1 : spanright[y];
+		const uint8 *src = overlay + (y * 256 + x1) * 4;
+		uint8 *row = dest + (y - yofs) * yscale * pitch;
+
+		for(int x = x1; x <= x2; x++, src += 4)
+		{
+			int a = src[3];
+			if(!a)
+				continue;
+
+			uint8 *d = row + (x - xofs) * xscale * Bpp;
+			uint32 pixel;
+			if(Bpp == 4)
+				pixel = *(uint32 *)d;
+			else
+				pixel = d[0] | (d[1] << 8) | (d[2] << 16);
+
+			uint32 color = 0;
+			for(int c = 0; c < 3; c++)
 			{
-			case 4:
-				pinc=pitch-(xr<<2);
-				for(y=yr;y;y--,src+=256-xr)
-				{
-					for(x=xr;x;x--)
-					{
-						//THE MAIN BLITTING CODEPATH (there may be others that are important)
-						*(uint32 *)dest = ModernDeemphColorMap(src,XBuf,1,1);
-						dest+=4;
-						src++;
-					}
-					dest+=pinc;
-				}
-				break;
-			case 3:
-				pinc=pitch-(xr+xr+xr);
-				for(y=yr;y;y--,src+=256-xr)
-				{
-					for(x=xr;x;x--)
-					{     
-						uint32 tmp = ModernDeemphColorMap(src,XBuf,1,1);
-						*(uint8 *)dest=tmp;
-						*((uint8 *)dest+1)=tmp>>8;
-						*((uint8 *)dest+2)=tmp>>16;
-						dest+=3;
-						src++;
-					}
-					dest+=pinc;
-				}
-				break;
-			case 2:
-				pinc=pitch-(xr<<1);
-				for(y=yr;y;y--,src+=256-xr)
+				int dc = (pixel >> cshiftl[c]) & 0xFF;
+				int sc = src[2 - c];
+				dc += (sc - dc) * a / 255;
+				color |= (uint32)dc << cshiftl[c];
+			}
+
+			for(int sy = 0; sy < yscale; sy++)
+			{
+				uint8 *o = d + sy * pitch;
+				for(int sx = 0; sx < xscale; sx++, o += Bpp)
 				{
-					for(x=xr;x;x--)
+					if(Bpp == 4)
+						*(uint32 *)o = color;
+					else
 					{
-						*(uint16 *)dest = ModernDeemphColorMap(src,XBuf,1,1);
-						dest+=2;
-						src++;
+						o[0] = color;
+						o[1] = color >> 8;
+						o[2] = color >> 16;
 					}
-					dest+=pinc;
 				}
-				break;
 			}
-	}
-	
-	if(specbuf)
-	{
-		if(specbuf32bpp)
-		{
-			// -Video Modes Tag-
-			int mult = (silt == 4)?3:2;
-			
-			if(silt == 4)
-				hq3x_32((uint8 *)specbuf,(uint8*)specbuf32bpp,xr,yr,xr*3*sizeof(uint32));
-			else
-				hq2x_32((uint8 *)specbuf,(uint8*)specbuf32bpp,xr,yr,xr*2*sizeof(uint32));
-			
-			if(backBpp == 2)
-				Blit32to16(specbuf32bpp, (uint16*)destbackup, xr*mult, yr*mult, pitchbackup, backshiftr,backshiftl);
-			else // == 3
-				Blit32to24(specbuf32bpp, (uint8*)destbackup, xr*mult, yr*mult, pitchbackup);
-		}
-		else
-		{
-			// -Video Modes Tag-
-			if(silt == 4)
-				hq3x_32((uint8 *)specbuf,destbackup,xr,yr,pitchbackup);
-			else
-				hq2x_32((uint8 *)specbuf,destbackup,xr,yr,pitchbackup);
 		}
 	}
 }
@@ -23,6 +23,8 @@ void SetPaletteBlitToHigh(uint8 *src);
 void KillBlitToHigh(void);
 void Blit8ToHigh(uint8 *src, uint8 *dest, int xr, int yr, int pitch, int xscale, int yscale);
 void Blit8To8(uint8 *src, uint8 *dest, int xr, int yr, int pitch, int xscale, int yscale, int efx, int special);
+void BlitOverlayToHigh(const uint8 *overlay, int firstline, int lastline, const int *spanleft, const int *spanright,
+                       int xofs, int yofs, uint8 *dest, int xr, int yr, int pitch, int xscale, int yscale);
 
 void Blit32to24(uint32 *src, uint8 *dest, int xr, int yr, int dpitch);
 void Blit32to16(uint32 *src, uint16 *dest, int xr, int yr, int dpitch,
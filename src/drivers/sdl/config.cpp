@@ -137,6 +137,7 @@ InitConfig()
 	config->addOption("soundrate", "SDL.Sound.Rate", 44100);
 	config->addOption("soundq", "SDL.Sound.Quality", 1);
 	config->addOption("soundrecord", "SDL.Sound.RecordFile", "");
+	config->addOption("avdump", "SDL.AVDump", "");
 	config->addOption("soundbufsize", "SDL.Sound.BufSize", 128);
 	config->addOption("lowpass", "SDL.Sound.LowPass", 0);
     
@@ -223,6 +224,35 @@ InitConfig()
 	config->addOption("playmov", "SDL.Movie", "");
 	config->addOption("subtitles", "SDL.SubtitleDisplay", 1);
 	config->addOption("movielength", "SDL.MovieLength", 0);
+
+	// parallel batch runs
+	config->addOption("batch", "SDL.Batch", "");
+	config->addOption("batchstate", "SDL.BatchState", "");
+	config->addOption("batchworkers", "SDL.BatchWorkers", 0);
+	config->addOption("batchframes", "SDL.BatchFrames", 0);
+	config->addOption("batchout", "SDL.BatchOut", "");
+
+	// rendering nsf tracks to files
+	config->addOption("nsfrender", "SDL.NSFRender", "");
+	config->addOption("nsflength", "SDL.NSFRender.Length", 180);
+	config->addOption("nsffade", "SDL.NSFRender.Fade", 5);
+	config->addOption("nsfsilence", "SDL.NSFRender.Silence", 2);
+	config->addOption("nsfloops", "SDL.NSFRender.Loops", 2);
+	config->addOption("nsfraw", "SDL.NSFRender.Raw", 0);
+
+	// hashing a rom collection into an index
+	config->addOption("scanroms", "SDL.ScanROMs", "");
+	config->addOption("romindex", "SDL.ROMIndex", dir + PSS + "romindex.txt");
+
+	// standalone code/data logger
+	config->addOption("cdlog", "SDL.CDLog", "");
+	config->addOption("cdloginterval", "SDL.CDLogInterval", 0);
+
+	// state digest log, for finding where two runs diverge
+	config->addOption("digestlog", "SDL.DigestLog", "");
+	config->addOption("digestframe", "SDL.DigestFrame", -1);
+	config->addOption("digestcompare", "SDL.DigestCompare", "");
+	config->addOption("hashbench", "SDL.HashBench", 0);
 	
 	config->addOption("fourscore", "SDL.FourScore", 0);
 
@@ -231,6 +261,8 @@ InitConfig()
     #ifdef _S9XLUA_H
 	// load lua script
 	config->addOption("loadlua", "SDL.LuaScript", "");
+	// blend the lua gui in RGB after palette expansion instead of into the 8-bit screen
+	config->addOption("luaguirgb", "SDL.LuaGuiRGB", 0);
     #endif
     
     #ifdef CREATE_AVI
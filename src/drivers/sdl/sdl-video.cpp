@@ -36,6 +36,10 @@
 #include "../common/configSys.h"
 #include "sdl-video.h"
 
+#ifdef _S9XLUA_H
+#include "../../fceulua.h"
+#endif
+
 #ifdef CREATE_AVI
 #include "../videolog/nesvideos-piece.h"
 #endif
@@ -80,6 +84,7 @@ static int s_nativeHeight = -1;
 #define NOFFSET	(s_clipSides ? 8 : 0)
 
 static int s_paletterefresh;
+static int s_luaRGBOverlay;
 
 extern bool MaxSpeed;
 
@@ -496,6 +501,18 @@ InitVideo(FCEUGI *gi)
 						s_screen->format->Gmask,
 						s_screen->format->Bmask,
 						s_eefx, s_sponge, 0);
+#ifdef _S9XLUA_H
+		// the lua gui can only be blended after palette expansion
+		// when the blit maps XBuf pixels 1:1 (no special filter)
+		g_config->getOption("SDL.LuaGuiRGB", &s_luaRGBOverlay);
+		if(s_sponge || s_curbpp < 24)
+			s_luaRGBOverlay = 0;
+#ifdef OPENGL
+		if(s_useOpenGL)
+			s_luaRGBOverlay = 0;
+#endif
+		FCEU_LuaGuiSetRGBOverlay(s_luaRGBOverlay != 0);
+#endif
 #ifdef OPENGL
 		if(s_useOpenGL) 
 		{
@@ -684,6 +701,18 @@ BlitScreen(uint8 *XBuf)
 			Blit8ToHigh(XBuf + NOFFSET, dest, NWIDTH, s_tlines,
 						TmpScreen->pitch, (int)s_exs, (int)s_eys);
 		}
+#ifdef _S9XLUA_H
+		if(s_luaRGBOverlay) {
+			int firstLine, lastLine;
+			const int *spanLeft, *spanRight;
+			const uint8 *overlay = FCEU_LuaGuiGetOverlay(&firstLine, &lastLine, &spanLeft, &spanRight);
+			if(overlay) {
+				BlitOverlayToHigh(overlay, firstLine, lastLine, spanLeft, spanRight,
+								NOFFSET, s_srendline, dest, NWIDTH, s_tlines, TmpScreen->pitch,
+								s_BlitBuf ? 1 : (int)s_exs, s_BlitBuf ? 1 : (int)s_eys);
+			}
+		}
+#endif
 	} else {
 		if(s_BlitBuf) {
 			Blit8To8(XBuf + NOFFSET, dest, NWIDTH, s_tlines,
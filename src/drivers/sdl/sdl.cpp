@@ -3,8 +3,10 @@
 #include "config.h"
 
 #include "../common/cheat.h"
+#include "../common/avdump.h"
 #include "../../fceu.h"
 #include "../../movie.h"
+#include "../../video.h"
 #include "../../version.h"
 #ifdef _S9XLUA_H
 #include "../../fceulua.h"
@@ -16,10 +18,13 @@
 #include "sdl.h"
 #include "sdl-video.h"
 #include "unix-netplay.h"
+#include "unix-batch.h"
 
 #include "../common/configSys.h"
 #include "../../oldmovie.h"
 #include "../../types.h"
+#include "../../utils/crc32.h"
+#include "../../utils/md5.h"
 
 #ifdef CREATE_AVI
 #include "../videolog/nesvideos-piece.h"
@@ -47,6 +52,9 @@
 #include <sys/stat.h>
 #include <iostream>
 #include <fstream>
+#include <chrono>
+#include <vector>
+#include <zlib.h>
 
 
 extern double g_fpsScale;
@@ -113,7 +121,31 @@ static const char *DriverUsage=
 "--soundbufsize x       Set sound buffer size to x ms.\n"
 "--volume      {0-256}  Set volume to x.\n"
 "--soundrecord  f       Record sound to file f.\n"
+"--avdump       f       Dump lossless video and sound to file f (.fcxav).\n"
+"--cdlog        f       Log code/data coverage of PRG to file f (.cdl),\n"
+"                       merging into f if it already exists.\n"
+"--cdloginterval x      Rewrite the code/data log every x frames.\n"
+"--digestlog    f       Log a digest of the emulator state after every frame to f.\n"
+"--digestframe  x       Also log a digest before every instruction of frame x.\n"
+"--digestcompare f      Compare digest log f against the --digestlog file and exit.\n"
+"--hashbench    x       Time crc32/md5 over x MiB of data and exit.\n"
 "--playmov      f       Play back a recorded FCM/FM2/FM3 movie from filename f.\n"
+"--batch        f       Run the movies/lua scripts listed in f in parallel\n"
+"                       from the loaded state, print results and exit.\n"
+"--batchstate   f       Load state file f before starting the batch.\n"
+"--batchworkers x       Use x worker processes (0 = one per cpu).\n"
+"--batchframes  x       Stop every batch job after x frames.\n"
+"--batchout     f       Write batch results to f instead of stdout.\n"
+"--nsfrender    p       Render every track of the NSF to p01.wav, p02.wav, ...\n"
+"                       using --batchworkers processes, print results and exit.\n"
+"--nsflength    x       Fade tracks out after at most x seconds.\n"
+"--nsffade      x       Fade out over x seconds.\n"
+"--nsfsilence   x       End a track after x seconds of silence (0 = never).\n"
+"--nsfloops     x       Fade out after x passes of a detected loop (0 = never).\n"
+"--nsfraw       {0|1}   Write raw 16 bit pcm instead of wav files.\n"
+"--scanroms     d       Hash every rom under directory d into the --romindex\n"
+"                       file using --batchworkers threads and exit.\n"
+"--romindex     f       Keep the rom index in f.\n"
 "--pauseframe   x       Pause movie playback at frame x.\n"
 "--fcmconvert   f       Convert fcm movie file f to fm2.\n"
 "--ripsubs      f       Convert movie's subtitles to srt\n"
@@ -164,6 +196,7 @@ static void ShowUsage(char *prog)
 	puts(DriverUsage);
 #ifdef _S9XLUA_H
 	puts ("--loadlua      f       Loads lua script from filename f.");
+	puts ("--luaguirgb   {0|1}    Blends the lua gui in RGB after palette expansion\n                         instead of into the 8-bit screen (unfiltered video only).");
 #endif
 #ifdef CREATE_AVI
 	puts ("--videolog     c       Calls mencoder to grab the video and audio streams to\n                         encode them. Check the documentation for more on this.");
@@ -229,6 +262,29 @@ int LoadGame(const char *path)
 			g_config->setOption("SDL.Sound.RecordFile", "");
 		}
 	}
+
+	g_config->getOption("SDL.CDLog", &filename);
+	if(filename.size()) {
+		g_config->getOption("SDL.CDLogInterval", &id);
+		if(!FCEUI_BeginCDLog(filename.c_str(), id)) {
+			FCEUD_PrintError("Couldn't start the code/data logger.");
+		}
+	}
+
+	g_config->getOption("SDL.DigestLog", &filename);
+	if(filename.size()) {
+		g_config->getOption("SDL.DigestFrame", &id);
+		if(!FCEUI_BeginDigestLog(filename.c_str(), id)) {
+			FCEUD_PrintError("Couldn't start the state digest log.");
+		}
+	}
+
+	g_config->getOption("SDL.AVDump", &filename);
+	if(filename.size()) {
+		if(!FCEUI_AviBegin(filename.c_str())) {
+			FCEUD_PrintError("Couldn't start the A/V dump.");
+		}
+	}
 	isloaded = 1;
 
 	FCEUD_NetworkConnect();
@@ -264,6 +320,8 @@ CloseGame()
 		FCEUI_EndWaveRecord();
 	}
 
+	FCEUI_AviEnd();
+
 	InputUserActiveFix();
 	return(1);
 }
@@ -284,6 +342,10 @@ static void DoFun(int frameskip, int periodic_saves)
     }
 #ifdef FRAMESKIP
 	fskipc = (fskipc + 1) % (frameskip + 1);
+	// every frame has to be rendered while dumping
+	if(AVDump_Active()) {
+		fskipc = 0;
+	}
 #endif
 
 	if(NoWaiting) {
@@ -527,6 +589,47 @@ void FCEUD_TraceInstruction() {
 
 int KillFCEUXonFrame = 0;
 
+/**
+ * Times the rom hashing routines over a buffer of the given size, checks
+ * CalcCRC32 against plain zlib and prints the throughput of each.
+ */
+static int HashBenchmark(int megabytes)
+{
+	std::vector<uint8> buf((size_t)megabytes << 20);
+	uint32 seed = 1;
+	for(size_t i = 0; i < buf.size(); i++) {
+		seed = seed * 1103515245 + 12345;
+		buf[i] = seed >> 16;
+	}
+
+	uint32 crcs[2] = { 0, 0 };
+	double secs[3];
+	for(int pass = 0; pass < 3; pass++) {
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		if(pass == 0)
+			crcs[0] = CalcCRC32(0, &buf[0], buf.size());
+		else if(pass == 1)
+			crcs[1] = crc32(0, &buf[0], buf.size());
+		else {
+			md5_context md5;
+			uint8 digest[16];
+			md5_starts(&md5);
+			md5_update(&md5, &buf[0], buf.size());
+			md5_finish(&md5, digest);
+		}
+		secs[pass] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	printf("crc32: %8.1f MB/s\n", megabytes / secs[0]);
+	printf(" zlib: %8.1f MB/s\n", megabytes / secs[1]);
+	printf("  md5: %8.1f MB/s\n", megabytes / secs[2]);
+	if(crcs[0] != crcs[1]) {
+		printf("crc32 mismatch: %08x, zlib says %08x\n", crcs[0], crcs[1]);
+		return -1;
+	}
+	return 0;
+}
+
 /**
  * The main loop for the SDL.
  */
@@ -811,6 +914,47 @@ int main(int argc, char *argv[])
 	}
    
 
+	// comparing two digest logs doesn't need a game
+	g_config->getOption("SDL.DigestCompare", &s);
+	if(!s.empty())
+	{
+		std::string log;
+		g_config->getOption("SDL.DigestLog", &log);
+		int ret = FCEUI_CompareDigestLogs(log.c_str(), s.c_str());
+		DriverKill();
+		SDL_Quit();
+		return ret < 0 ? -1 : ret;
+	}
+
+	// nor does timing the hash routines
+	int hashbench;
+	g_config->getOption("SDL.HashBench", &hashbench);
+	if(hashbench > 0)
+	{
+		int ret = HashBenchmark(hashbench);
+		DriverKill();
+		SDL_Quit();
+		return ret;
+	}
+
+	// or indexing a rom collection
+	g_config->getOption("SDL.ScanROMs", &s);
+	if(!s.empty())
+	{
+		std::string index;
+		int workers, hashed;
+		g_config->getOption("SDL.ROMIndex", &index);
+		g_config->getOption("SDL.BatchWorkers", &workers);
+		int count = FCEUI_ScanROMs(s.c_str(), index.c_str(), workers, &hashed);
+		if(count < 0)
+			FCEUD_PrintError("Couldn't write the rom index.");
+		else
+			printf("%d roms indexed in %s (%d files hashed).\n", count, index.c_str(), hashed);
+		DriverKill();
+		SDL_Quit();
+		return count < 0 ? -1 : 0;
+	}
+
 	// if we're not compiling w/ the gui, exit if a rom isn't specified
 #ifndef _GTK
 	if(romIndex <= 0) {
@@ -926,6 +1070,48 @@ int main(int argc, char *argv[])
 			newppu = 1;
 	}
 
+	// batch mode: run the jobs in parallel from the current state and exit
+	g_config->getOption("SDL.Batch", &s);
+	if (s != "" && GameInfo)
+	{
+		std::string state, out;
+		int workers, frames;
+		g_config->getOption("SDL.BatchState", &state);
+		g_config->getOption("SDL.BatchWorkers", &workers);
+		g_config->getOption("SDL.BatchFrames", &frames);
+		g_config->getOption("SDL.BatchOut", &out);
+		int ret = BatchRun(s.c_str(), state.c_str(), workers, frames, out.c_str());
+		CloseGame();
+		FCEUI_Kill();
+		SDL_Quit();
+		return ret;
+	}
+
+	// nsf rendering: write every track to a file and exit
+	g_config->getOption("SDL.NSFRender", &s);
+	if (s != "" && GameInfo)
+	{
+		NSFRenderOptions opt;
+		std::string out;
+		int raw;
+		opt.prefix = s.c_str();
+		g_config->getOption("SDL.BatchWorkers", &opt.workers);
+		g_config->getOption("SDL.Sound.Rate", &opt.rate);
+		g_config->getOption("SDL.Sound.Quality", &opt.quality);
+		g_config->getOption("SDL.NSFRender.Length", &opt.length);
+		g_config->getOption("SDL.NSFRender.Fade", &opt.fade);
+		g_config->getOption("SDL.NSFRender.Silence", &opt.silence);
+		g_config->getOption("SDL.NSFRender.Loops", &opt.loops);
+		g_config->getOption("SDL.NSFRender.Raw", &raw);
+		g_config->getOption("SDL.BatchOut", &out);
+		opt.raw = raw != 0;
+		int ret = NSFRender(opt, out.c_str());
+		CloseGame();
+		FCEUI_Kill();
+		SDL_Quit();
+		return ret;
+	}
+
 	g_config->getOption("SDL.Frameskip", &frameskip);
 	// loop playing the game
 #ifdef _GTK
@@ -1019,6 +1205,16 @@ void FCEUD_PrintError(const char *errormsg)
 }
 
 
+// A/V dumping, see drivers/common/avdump.h
+int FCEUI_AviBegin(const char* fname)
+{
+	return AVDump_Begin(fname, FCEUI_GetDesiredFPS(), FSettings.SndRate);
+}
+void FCEUI_AviEnd(void) { AVDump_End(); }
+void FCEUI_AviVideoUpdate(const unsigned char* buffer) { AVDump_Video(buffer, XDBuf); }
+void FCEUI_AviSoundUpdate(void* soundData, int soundLen) { AVDump_Audio((const int16*)soundData, soundLen); }
+bool FCEUI_AviIsRecording(void) { return AVDump_Active(); }
+
 // dummy functions
 
 #define DUMMY(__f) \
@@ -1031,9 +1227,7 @@ DUMMY(FCEUD_MovieReplayFrom)
 DUMMY(FCEUD_ToggleStatusIcon)
 DUMMY(FCEUD_AviRecordTo)
 DUMMY(FCEUD_AviStop)
-void FCEUI_AviVideoUpdate(const unsigned char* buffer) { }
 int FCEUD_ShowStatusIcon(void) {return 0;}
-bool FCEUI_AviIsRecording(void) {return false;}
 void FCEUI_UseInputPreset(int preset) { }
 bool FCEUD_PauseAfterPlayback() { return false; }
 // These are actually fine, but will be unused and overriden by the current UI code.
@@ -0,0 +1,512 @@
+/// \file
+/// \brief Forks worker processes that run jobs from a shared base state or render NSF tracks.
+
+#include "main.h"
+#include "unix-batch.h"
+
+#include "../../fceu.h"
+#include "../../fceulua.h"
+#include "../../driver.h"
+#include "../../emufile.h"
+#include "../../movie.h"
+#include "../../state.h"
+#include "../../cheat.h"
+#include "../../git.h"
+#include "../../utils/crc32.h"
+
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <zlib.h>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+enum
+{
+	BATCH_PENDING = 0,
+	BATCH_DONE,
+	BATCH_FAILED,
+};
+
+struct BatchResult
+{
+	int32 status;
+	uint32 frames;
+	uint32 ramCRC;
+	uint32 stateCRC;
+};
+
+// lives in a MAP_SHARED mapping so the parent sees what the workers write
+struct BatchTable
+{
+	int nextJob;
+	BatchResult results[1];
+};
+
+static bool RunJob(const std::string &job, int frames, EMUFILE_MEMORY &base, BatchResult &res)
+{
+	base.fseek(0, SEEK_SET);
+	if(!FCEUSS_LoadFP(&base, SSLOADPARAM_NOBACKUP))
+		return false;
+
+	bool lua = job.size() > 4 && job.compare(job.size() - 4, 4, ".lua") == 0;
+	if(lua)
+	{
+#ifdef _S9XLUA_H
+		if(!frames || !FCEU_LoadLuaCode(job.c_str()))
+			return false;
+#else
+		return false;
+#endif
+	}
+	else
+	{
+		if(!FCEUMOV_PlayInputFrom(job.c_str()))
+			return false;
+		int length = FCEUI_GetMovieLength();
+		if(!frames || frames > length)
+			frames = length;
+	}
+
+	uint8 *gfx;
+	int32 *sound;
+	int32 ssize;
+	int f;
+	for(f = 0; f < frames; f++)
+	{
+#ifdef _S9XLUA_H
+		if(lua && !FCEU_LuaRunning())
+			break;
+#endif
+		FCEUI_Emulate(&gfx, &sound, &ssize, 2);
+	}
+
+#ifdef _S9XLUA_H
+	if(lua)
+		FCEU_LuaStop();
+#endif
+	FCEUI_StopMovie();
+
+	EMUFILE_MEMORY state;
+	FCEUSS_SaveMS(&state, Z_NO_COMPRESSION);
+	res.frames = f;
+	res.ramCRC = CalcCRC32(0, RAM, 0x800);
+	res.stateCRC = CalcCRC32(0, state.buf(), state.size());
+	return true;
+}
+
+struct BatchContext
+{
+	BatchTable *table;
+	const std::vector<std::string> *jobs;
+	int frames;
+	EMUFILE_MEMORY *base;
+};
+
+static void Worker(void *param)
+{
+	BatchContext &ctx = *(BatchContext*)param;
+	// nobody looks at the picture or listens to the sound
+	FCEUI_SetComputeOnly(true);
+	for(;;)
+	{
+		int job = __sync_fetch_and_add(&ctx.table->nextJob, 1);
+		if(job >= (int)ctx.jobs->size())
+			break;
+		BatchResult &res = ctx.table->results[job];
+		res.status = RunJob((*ctx.jobs)[job], ctx.frames, *ctx.base, res) ? BATCH_DONE : BATCH_FAILED;
+	}
+}
+
+// forks `workers` processes running work(ctx), which inherit the emulator copy-on-write, and waits for them
+static void RunWorkers(int workers, void (*work)(void *), void *ctx)
+{
+	// flush before forking so buffered output isn't written once per worker
+	fflush(stdout);
+	fflush(stderr);
+
+	std::vector<pid_t> pids;
+	for(int w = 0; w < workers; w++)
+	{
+		pid_t pid = fork();
+		if(pid == 0)
+		{
+			work(ctx);
+			// skip atexit handlers and SDL teardown, they belong to the parent
+			_exit(0);
+		}
+		if(pid < 0)
+		{
+			FCEUD_PrintError("fork() failed, running the remaining jobs in this process.");
+			work(ctx);
+			break;
+		}
+		pids.push_back(pid);
+	}
+	for(size_t i = 0; i < pids.size(); i++)
+	{
+		int status;
+		while(waitpid(pids[i], &status, 0) < 0 && errno == EINTR)
+			;
+	}
+}
+
+static void *MapShared(size_t size)
+{
+	void *p = mmap(0, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if(p == MAP_FAILED)
+		return 0;
+	memset(p, 0, size);
+	return p;
+}
+
+int BatchRun(const char *jobsFile, const char *stateFile, int workers, int frames, const char *outFile)
+{
+	if(stateFile && *stateFile && !FCEUSS_Load(stateFile, false))
+	{
+		FCEUD_PrintError("Couldn't load the batch base state.");
+		return 1;
+	}
+
+	std::vector<std::string> jobs;
+	FILE *fp = FCEUD_UTF8fopen(jobsFile, "rb");
+	if(!fp)
+	{
+		FCEUD_PrintError("Couldn't open the batch job list.");
+		return 1;
+	}
+	char line[2048];
+	while(fgets(line, sizeof(line), fp))
+	{
+		size_t len = strcspn(line, "\r\n");
+		line[len] = 0;
+		if(len && line[0] != '#')
+			jobs.push_back(line);
+	}
+	fclose(fp);
+	if(jobs.empty())
+		return 0;
+
+	if(workers < 1)
+		workers = sysconf(_SC_NPROCESSORS_ONLN);
+	if(workers > (int)jobs.size())
+		workers = jobs.size();
+	if(workers < 1)
+		workers = 1;
+
+	size_t tableSize = sizeof(BatchTable) + jobs.size() * sizeof(BatchResult);
+	BatchTable *table = (BatchTable*)MapShared(tableSize);
+	if(!table)
+	{
+		FCEUD_PrintError("Couldn't map the batch result table.");
+		return 1;
+	}
+
+	// every job starts from this state, restored from memory rather than from disk
+	EMUFILE_MEMORY base;
+	FCEUSS_SaveMS(&base, Z_NO_COMPRESSION);
+
+	BatchContext ctx = { table, &jobs, frames, &base };
+	RunWorkers(workers, Worker, &ctx);
+
+	// put the parent back where it was in case it keeps running
+	base.fseek(0, SEEK_SET);
+	FCEUSS_LoadFP(&base, SSLOADPARAM_NOBACKUP);
+
+	FILE *out = stdout;
+	if(outFile && *outFile && !(out = FCEUD_UTF8fopen(outFile, "wb")))
+	{
+		FCEUD_PrintError("Couldn't create the batch result file.");
+		out = stdout;
+	}
+
+	int failed = 0;
+	for(size_t i = 0; i < jobs.size(); i++)
+	{
+		BatchResult &res = table->results[i];
+		if(res.status != BATCH_DONE)
+		{
+			// a worker that crashed leaves its job pending
+			fprintf(out, "%s\t%s\n", jobs[i].c_str(), res.status == BATCH_FAILED ? "failed" : "crashed");
+			failed++;
+			continue;
+		}
+		fprintf(out, "%s\tok\t%u\t%08x\t%08x\n", jobs[i].c_str(), res.frames, res.ramCRC, res.stateCRC);
+	}
+	if(out != stdout)
+		fclose(out);
+
+	munmap(table, tableSize);
+	return failed ? 1 : 0;
+}
+
+enum
+{
+	NSF_END_LENGTH = 0,
+	NSF_END_LOOP,
+	NSF_END_SILENCE,
+};
+
+static const char *nsfEndNames[] = { "length", "loop", "silence" };
+
+// a frame whose samples all stay within this is silent
+#define NSF_SILENCE_LEVEL 64
+
+struct NSFTrackResult
+{
+	int32 status;
+	int32 end;
+	uint32 samples;
+	uint32 loopSamples;
+};
+
+struct NSFTable
+{
+	int nextTrack;
+	NSFTrackResult results[1];
+};
+
+struct NSFContext
+{
+	NSFTable *table;
+	int tracks;
+	NSFRenderOptions opt;
+};
+
+static void Put16(FILE *fp, uint32 v)
+{
+	fputc(v & 0xFF, fp);
+	fputc((v >> 8) & 0xFF, fp);
+}
+
+static void Put32(FILE *fp, uint32 v)
+{
+	Put16(fp, v & 0xFFFF);
+	Put16(fp, v >> 16);
+}
+
+// 16 bit mono little endian, with a RIFF header unless raw
+static bool WriteTrack(const char *fn, const std::vector<int16> &samples, int rate, bool raw)
+{
+	FILE *fp = FCEUD_UTF8fopen(fn, "wb");
+	if(!fp)
+		return false;
+	uint32 bytes = samples.size() * 2;
+	if(!raw)
+	{
+		fwrite("RIFF", 1, 4, fp);
+		Put32(fp, 36 + bytes);
+		fwrite("WAVEfmt ", 1, 8, fp);
+		Put32(fp, 16);
+		Put16(fp, 1);        // pcm
+		Put16(fp, 1);        // channels
+		Put32(fp, rate);
+		Put32(fp, rate * 2); // bytes per second
+		Put16(fp, 2);        // block align
+		Put16(fp, 16);       // bits per sample
+		fwrite("data", 1, 4, fp);
+		Put32(fp, bytes);
+	}
+	for(size_t i = 0; i < samples.size(); i++)
+		Put16(fp, (uint16)samples[i]);
+	bool ok = !ferror(fp);
+	return fclose(fp) == 0 && ok;
+}
+
+// identifies the sound driver's state: work RAM plus the $6000-$7FFF area
+static uint64 NSFStateKey()
+{
+	uint8 wram[0x2000];
+	for(int a = 0; a < 0x2000; a++)
+		wram[a] = FCEU_CheatGetByte(0x6000 + a);
+	return ((uint64)CalcCRC32(0, RAM, 0x800) << 32) | CalcCRC32(0, wram, sizeof(wram));
+}
+
+static bool RenderTrack(int track, const NSFRenderOptions &opt, NSFTrackResult &res)
+{
+	FCEUI_PowerNES();
+	int cur = FCEUI_NSFChange(0);
+	if(FCEUI_NSFChange(track - cur) != track)
+		return false;
+
+	uint32 rate = opt.rate;
+	uint32 fadeLen = opt.fade * rate;
+	uint32 silenceLen = opt.silence * rate;
+	uint32 maxLen = opt.length * rate;
+	// stop at maxLen, fading out over its last fadeLen samples, unless a loop or silence ends the track earlier
+	uint32 fadeAt = maxLen > fadeLen ? maxLen - fadeLen : 0;
+	uint32 end = fadeAt + fadeLen;
+
+	std::vector<int16> samples;
+	samples.reserve(end + rate);
+	// state key -> sample position where it was last seen
+	std::map<uint64, uint32> seen;
+	int64 silentFrom = -1;
+	bool heard = false;
+	res.end = NSF_END_LENGTH;
+	res.loopSamples = 0;
+
+	while(samples.size() < end)
+	{
+		uint8 *gfx;
+		int32 *sound;
+		int32 ssize;
+		uint32 start = samples.size();
+		FCEUI_Emulate(&gfx, &sound, &ssize, 0);
+
+		bool silent = true;
+		for(int32 i = 0; i < ssize; i++)
+		{
+			int32 s = sound[i];
+			if(s > 32767) s = 32767;
+			if(s < -32768) s = -32768;
+			if(s > NSF_SILENCE_LEVEL || s < -NSF_SILENCE_LEVEL)
+				silent = false;
+			samples.push_back(s);
+		}
+		uint32 pos = samples.size();
+
+		if(!silent)
+		{
+			heard = true;
+			silentFrom = -1;
+		}
+		else
+		{
+			if(silentFrom < 0)
+				silentFrom = start;
+			// give a track that hasn't started yet longer to make its first sound
+			if(silenceLen && pos - silentFrom >= (heard ? silenceLen : 3 * silenceLen))
+			{
+				samples.resize(silentFrom);
+				res.end = NSF_END_SILENCE;
+				break;
+			}
+		}
+
+		if(opt.loops && !res.loopSamples)
+		{
+			// the same driver state means the song repeats from here as it did from there; loops
+			// shorter than a second are a driver idling in place, which the silence check handles
+			std::pair<std::map<uint64, uint32>::iterator, bool> ins = seen.insert(std::make_pair(NSFStateKey(), pos));
+			if(!ins.second)
+			{
+				uint32 prev = ins.first->second;
+				ins.first->second = pos;
+				if(pos - prev >= rate)
+				{
+					res.loopSamples = pos - prev;
+					// anything before prev is intro, so this plays at least opt.loops full passes
+					uint64 loopEnd = prev + (uint64)opt.loops * res.loopSamples;
+					if(loopEnd < pos)
+						loopEnd = pos;
+					if(loopEnd < fadeAt)
+					{
+						fadeAt = loopEnd;
+						end = fadeAt + fadeLen;
+						res.end = NSF_END_LOOP;
+					}
+				}
+			}
+		}
+	}
+
+	if(res.end != NSF_END_SILENCE)
+	{
+		if(samples.size() > end)
+			samples.resize(end);
+		for(uint32 i = fadeAt; i < samples.size(); i++)
+			samples[i] = (int64)samples[i] * (end - i) / (fadeLen + 1);
+	}
+	res.samples = samples.size();
+
+	char fn[2048];
+	snprintf(fn, sizeof(fn), "%s%02d.%s", opt.prefix, track, opt.raw ? "raw" : "wav");
+	return WriteTrack(fn, samples, rate, opt.raw);
+}
+
+static void NSFWorker(void *param)
+{
+	NSFContext &ctx = *(NSFContext*)param;
+	// only the sound is wanted
+	FCEUI_SetComputeOnly(true, true);
+	FCEUI_SetSoundQuality(ctx.opt.quality);
+	FCEUI_Sound(ctx.opt.rate);
+	for(;;)
+	{
+		int track = __sync_fetch_and_add(&ctx.table->nextTrack, 1);
+		if(track >= ctx.tracks)
+			break;
+		NSFTrackResult &res = ctx.table->results[track];
+		res.status = RenderTrack(track + 1, ctx.opt, res) ? BATCH_DONE : BATCH_FAILED;
+	}
+}
+
+int NSFRender(const NSFRenderOptions &opt, const char *outFile)
+{
+	if(!GameInfo || GameInfo->type != GIT_NSF)
+	{
+		FCEUD_PrintError("NSF rendering needs an NSF file.");
+		return 1;
+	}
+	if(opt.rate <= 0 || opt.length <= 0)
+	{
+		FCEUD_PrintError("Invalid NSF render length or sound rate.");
+		return 1;
+	}
+
+	uint8 name[33], artist[33], copyright[33];
+	int tracks = FCEUI_NSFGetInfo(name, artist, copyright, 32);
+	if(tracks < 1)
+		return 0;
+
+	int workers = opt.workers;
+	if(workers < 1)
+		workers = sysconf(_SC_NPROCESSORS_ONLN);
+	if(workers > tracks)
+		workers = tracks;
+	if(workers < 1)
+		workers = 1;
+
+	size_t tableSize = sizeof(NSFTable) + tracks * sizeof(NSFTrackResult);
+	NSFTable *table = (NSFTable*)MapShared(tableSize);
+	if(!table)
+	{
+		FCEUD_PrintError("Couldn't map the NSF result table.");
+		return 1;
+	}
+
+	NSFContext ctx = { table, tracks, opt };
+	RunWorkers(workers, NSFWorker, &ctx);
+
+	FILE *out = stdout;
+	if(outFile && *outFile && !(out = FCEUD_UTF8fopen(outFile, "wb")))
+	{
+		FCEUD_PrintError("Couldn't create the NSF result file.");
+		out = stdout;
+	}
+
+	int failed = 0;
+	for(int i = 0; i < tracks; i++)
+	{
+		NSFTrackResult &res = table->results[i];
+		if(res.status != BATCH_DONE)
+		{
+			fprintf(out, "%d\t%s\n", i + 1, res.status == BATCH_FAILED ? "failed" : "crashed");
+			failed++;
+			continue;
+		}
+		fprintf(out, "%d\tok\t%.2f\t%s\t%.2f\n", i + 1, (double)res.samples / opt.rate,
+			nsfEndNames[res.end], (double)res.loopSamples / opt.rate);
+	}
+	if(out != stdout)
+		fclose(out);
+
+	munmap(table, tableSize);
+	return failed ? 1 : 0;
+}
@@ -0,0 +1,39 @@
+#ifndef __UNIX_BATCH_H
+#define __UNIX_BATCH_H
+
+// Parallel batch runs for the loaded game. The base state is stateFile, or the
+// current emulator state if that is empty. It is kept in memory, then `workers` processes are forked and
+// inherit the warmed-up emulator copy-on-write. Each worker pulls jobs from the
+// list in jobsFile (one file per line: an .fm2 movie whose input is played
+// from the base state, or a .lua script that drives the input itself),
+// restores the base state, runs the job and stores frames, a RAM hash and a
+// final state hash in a shared-memory table. The parent collects the table
+// and writes one tab separated line per job to outFile (stdout if empty).
+//
+// frames limits every job (0 = movie length; Lua jobs need a limit).
+// Returns 0 if every job ran.
+int BatchRun(const char *jobsFile, const char *stateFile, int workers, int frames, const char *outFile);
+
+struct NSFRenderOptions
+{
+	const char *prefix; // output files are prefix01.wav, prefix02.wav, ...
+	int workers;        // 0 = one per cpu
+	int rate;
+	int quality;
+	int length;         // seconds before a track is faded out
+	int fade;           // seconds
+	int silence;        // seconds of silence that end a track
+	int loops;          // passes of a detected loop before fading (0 = don't look for loops)
+	bool raw;           // headerless 16 bit pcm instead of wav
+};
+
+// Renders every track of the loaded NSF to its own file, without video and
+// faster than real time, with the tracks spread over forked worker processes.
+// A track ends after opt.silence seconds of silence (trimmed off), or fades out
+// after opt.loops passes of a loop, found by the sound driver's RAM repeating,
+// or at opt.length seconds. One tab separated line per track is written to
+// outFile (stdout if empty): track, status, seconds, end reason, loop seconds.
+// Returns 0 if every track was written.
+int NSFRender(const NSFRenderOptions &opt, const char *outFile);
+
+#endif
@@ -1151,6 +1151,7 @@ void EnableBreak(int sel)
 	if(sel<0) return;
 	if(sel>=numWPs) return;
 	watchpoint[sel].flags^=WP_E;
+	InvalidateWatchpointIndex();
 	SendDlgItemMessage(hDebug,IDC_DEBUGGER_BP_LIST,LB_DELETESTRING,sel,0);
 	SendDlgItemMessage(hDebug,IDC_DEBUGGER_BP_LIST,LB_INSERTSTRING,sel,(LPARAM)(LPSTR)BreakToText(sel));
 	SendDlgItemMessage(hDebug,IDC_DEBUGGER_BP_LIST,LB_SETCURSEL,sel,0);
@@ -1186,6 +1187,7 @@ void DeleteBreak(int sel)
 	watchpoint[numWPs].condText = 0;
 	watchpoint[numWPs].desc = 0;
 	numWPs--;
+	InvalidateWatchpointIndex();
 // ################################## Start of SP CODE ###########################
 	myNumWPs--;
 // ################################## End of SP CODE ###########################
@@ -1495,6 +1497,7 @@ void LoadGameDebuggerData(HWND hwndDlg = hDebug)
 		return;
 
 	numWPs = myNumWPs;
+	InvalidateWatchpointIndex();
 	FillDebuggerBookmarkListbox(hwndDlg);
 	FillBreakList(hwndDlg);
 }
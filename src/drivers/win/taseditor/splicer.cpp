@@ -111,7 +111,6 @@ void SPLICER::cloneSelectedFrames()
 
 	selection.clearAllRowsSelection();			// Selection will be moved down, so that same frames are selected
 	bool markers_changed = false;
-	currMovieData.records.reserve(currMovieData.getNumRecords() + frames);
 	// insert frames before each selection, but consecutive Selection lines are accounted as single region
 	RowsSelection::reverse_iterator next_it;
 	RowsSelection::reverse_iterator current_selection_rend = current_selection->rend();
@@ -160,7 +159,6 @@ void SPLICER::insertSelectedFrames()
 
 	selection.clearAllRowsSelection();			// Selection will be moved down, so that same frames are selected
 	bool markers_changed = false;
-	currMovieData.records.reserve(currMovieData.getNumRecords() + frames);
 	// insert frames before each selection, but consecutive Selection lines are accounted as single region
 	RowsSelection::reverse_iterator next_it;
 	RowsSelection::reverse_iterator current_selection_rend = current_selection->rend();
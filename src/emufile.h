@@ -56,8 +56,8 @@ public:
 
 	static bool readAllBytes(std::vector<u8>* buf, const std::string& fname);
 
-	bool fail(bool unset=false) { bool ret = failbit; if(unset) unfail(); return ret; }
-	void unfail() { failbit=false; }
+	virtual bool fail(bool unset=false) { bool ret = failbit; if(unset) unfail(); return ret; }
+	virtual void unfail() { failbit=false; }
 
 	bool eof() { return size()==ftell(); }
 
@@ -0,0 +1,174 @@
+#include "emufile_async.h"
+
+//output is handed to the worker once this much has been collected, even without fflush()
+#define ASYNC_CHUNK (64*1024)
+
+EMUFILE_ASYNC::EMUFILE_ASYNC(EMUFILE* target)
+	: target(target)
+	, pendingSeek(-1)
+	, writeFailed(false)
+	, busy(false)
+	, quit(false)
+{
+	pos = target->ftell();
+	len = target->size();
+	pending.reserve(ASYNC_CHUNK);
+	worker = std::thread(&EMUFILE_ASYNC::run, this);
+}
+
+EMUFILE_ASYNC::~EMUFILE_ASYNC()
+{
+	submit(true);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		quit = true;
+	}
+	wake.notify_one();
+	worker.join();
+	delete target;
+}
+
+void EMUFILE_ASYNC::submit(bool flush)
+{
+	if (pending.empty() && pendingSeek < 0 && !flush)
+		return;
+
+	Op* op = new Op();
+	op->data.swap(pending);
+	op->seek = pendingSeek;
+	op->flush = flush;
+	pendingSeek = -1;
+	pending.reserve(ASYNC_CHUNK);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		queue.push_back(op);
+	}
+	wake.notify_one();
+}
+
+void EMUFILE_ASYNC::run()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	for(;;)
+	{
+		while (queue.empty() && !quit)
+			wake.wait(lock);
+		if (queue.empty())
+			break;
+
+		Op* op = queue.front();
+		queue.pop_front();
+		busy = true;
+		lock.unlock();
+
+		if (op->seek >= 0)
+			target->fseek(op->seek, SEEK_SET);
+		if (!op->data.empty())
+			target->fwrite(&op->data[0], op->data.size());
+		if (op->flush)
+			target->fflush();
+		bool failed = target->fail();
+		delete op;
+
+		if (failed)
+			writeFailed = true;
+
+		lock.lock();
+		busy = false;
+		if (queue.empty())
+			idle.notify_all();
+	}
+}
+
+void EMUFILE_ASYNC::drain()
+{
+	submit(false);
+	std::unique_lock<std::mutex> lock(mutex);
+	while (!queue.empty() || busy)
+		idle.wait(lock);
+}
+
+int EMUFILE_ASYNC::fprintf(const char *format, ...)
+{
+	char buf[1024];
+	va_list argptr;
+	va_start(argptr, format);
+	int ret = vsnprintf(buf, sizeof(buf), format, argptr);
+	va_end(argptr);
+
+	if (ret < 0)
+		return ret;
+	if (ret < (int)sizeof(buf))
+	{
+		fwrite(buf, ret);
+		return ret;
+	}
+
+	std::vector<char> big(ret + 1);
+	va_start(argptr, format);
+	vsnprintf(&big[0], big.size(), format, argptr);
+	va_end(argptr);
+	fwrite(&big[0], ret);
+	return ret;
+}
+
+int EMUFILE_ASYNC::fputc(int c)
+{
+	pending.push_back((u8)c);
+	pos++;
+	if (pos > len)
+		len = pos;
+	if (pending.size() >= ASYNC_CHUNK)
+		submit(false);
+	return c;
+}
+
+void EMUFILE_ASYNC::fwrite(const void *ptr, size_t bytes)
+{
+	const u8* src = (const u8*)ptr;
+	pending.insert(pending.end(), src, src + bytes);
+	pos += (int)bytes;
+	if (pos > len)
+		len = pos;
+	if (pending.size() >= ASYNC_CHUNK)
+		submit(false);
+}
+
+int EMUFILE_ASYNC::fseek(int offset, int origin)
+{
+	switch (origin)
+	{
+	case SEEK_SET: break;
+	case SEEK_CUR: offset += pos; break;
+	case SEEK_END: offset += len; break;
+	default: return -1;
+	}
+	if (offset < 0)
+		return -1;
+	if (offset == pos)
+		return 0;
+
+	submit(false);
+	pendingSeek = offset;
+	pos = offset;
+	return 0;
+}
+
+int EMUFILE_ASYNC::size()
+{
+	return len;
+}
+
+void EMUFILE_ASYNC::fflush()
+{
+	submit(true);
+}
+
+void EMUFILE_ASYNC::truncate(s32 length)
+{
+	drain();
+	target->truncate(length);
+	len = length;
+	if (pos > len)
+		pos = len;
+}
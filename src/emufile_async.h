@@ -0,0 +1,70 @@
+#ifndef EMUFILE_ASYNC_H
+#define EMUFILE_ASYNC_H
+
+#include "emufile.h"
+
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+//a write-only EMUFILE which collects output in memory and passes it to a worker thread that writes
+//it to the wrapped EMUFILE. writes, seeks and flushes are queued in order, so the caller never waits
+//on the disk. only truncate() has to wait until the queue is empty.
+class EMUFILE_ASYNC : public EMUFILE {
+public:
+	//takes ownership of target
+	EMUFILE_ASYNC(EMUFILE* target);
+	virtual ~EMUFILE_ASYNC();
+
+	virtual EMUFILE* memwrap() { return NULL; }
+	virtual FILE *get_fp() { return NULL; }
+
+	virtual int fprintf(const char *format, ...);
+
+	//failbit belongs to the calling thread; errors from the worker arrive through writeFailed
+	virtual bool fail(bool unset=false) { bool ret = failbit || writeFailed; if(unset) unfail(); return ret; }
+	virtual void unfail() { failbit = false; writeFailed = false; }
+
+	virtual int fgetc() { failbit = true; return -1; }
+	virtual int fputc(int c);
+
+	virtual size_t _fread(const void *ptr, size_t bytes) { failbit = true; return 0; }
+	virtual void fwrite(const void *ptr, size_t bytes);
+
+	virtual int fseek(int offset, int origin);
+	virtual int ftell() { return pos; }
+	virtual int size();
+	virtual void fflush();
+	virtual void truncate(s32 length);
+
+	//blocks until everything written so far has reached the wrapped EMUFILE
+	void drain();
+
+private:
+	struct Op
+	{
+		std::vector<u8> data;
+		int seek; //-1 to write at the current position
+		bool flush;
+	};
+
+	EMUFILE* target;
+	std::vector<u8> pending;
+	int pendingSeek;
+	int pos, len;
+
+	std::atomic<bool> writeFailed;
+
+	std::deque<Op*> queue;
+	bool busy, quit;
+	std::mutex mutex;
+	std::condition_variable wake, idle;
+	std::thread worker;
+
+	void submit(bool flush);
+	void run();
+};
+
+#endif
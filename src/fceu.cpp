@@ -42,6 +42,9 @@
 #include "input.h"
 #include "file.h"
 #include "vsuni.h"
+#include "cdl.h"
+#include "instance.h"
+#include "digest.h"
 #include "ines.h"
 #ifdef WIN32
 #include "drivers/win/pref.h"
@@ -101,6 +104,27 @@ bool skip_7bit_overclocking = 1; // 7-bit samples have priority over overclockin
 int normalscanlines;
 int totalscanlines;
 int postrenderscanlines = 0;
+
+// compute-only mode: emulate everything the cpu can observe (sprite 0 hits, sprite overflow, zapper
+// light sensing, mapper ppu hooks, apu length counters and irqs) but produce no picture and,
+// unless computeSound is set, no sound
+bool computeOnly = false;
+bool computeSound = false;
+
+void FCEUI_SetComputeOnly(bool on, bool sound)
+{
+	if (computeOnly == on && computeSound == sound)
+		return;
+	computeOnly = on;
+	computeSound = sound;
+	// swaps the channel synthesizers for no-ops and back, resetting the output position
+	SetSoundVariables();
+}
+
+bool FCEUI_GetComputeOnly(void)
+{
+	return computeOnly;
+}
 int vblankscanlines = 0;
 //------------
 
@@ -179,6 +203,11 @@ static void FCEU_CloseGame(void)
 		CDLoggerROMClosed();
 #endif
 
+		FCEUI_EndCDLog();
+		FCEUI_EndDigestLog();
+		FCEU_RamSearchClose();
+		FCEU_CloseInstances();
+
 		if (FCEUnetplay) {
 			FCEUD_NetworkClose();
 		}
@@ -656,7 +685,7 @@ void UpdateAutosave(void);
 ///Skip may be passed in, if FRAMESKIP is #defined, to cause this to emulate more than one frame
 void FCEUI_Emulate(uint8 **pXBuf, int32 **SoundBuf, int32 *SoundBufSize, int skip) {
 	//skip initiates frame skip if 1, or frame skip and sound skip if 2
-	int r, ssize;
+	int r, ssize = 0;
 
 	JustFrameAdvanced = false;
 
@@ -713,6 +742,7 @@ void FCEUI_Emulate(uint8 **pXBuf, int32 **SoundBuf, int32 *SoundBufSize, int ski
 
 	AutoFire();
 	UpdateAutosave();
+	FCEU_CDLogFrame();
 
 #ifdef _S9XLUA_H
 	FCEU_LuaFrameBoundary();
@@ -726,15 +756,18 @@ void FCEUI_Emulate(uint8 **pXBuf, int32 **SoundBuf, int32 *SoundBufSize, int ski
 #endif
 
 	if (geniestage != 1) FCEU_ApplyPeriodicCheats();
+	FCEU_DigestFrameBegin();
 	r = FCEUPPU_Loop(skip);
 
-	if (skip != 2) ssize = FlushEmulateSound();  //If skip = 2 we are skipping sound processing
+	if (computeOnly && !computeSound) ssize = 0;
+	else if (skip != 2) ssize = FlushEmulateSound();  //If skip = 2 we are skipping sound processing
 
 #ifdef _S9XLUA_H
 	CallRegisteredLuaFunctions(LUACALL_AFTEREMULATION);
 #endif
 
-	FCEU_PutImage();
+	if (!computeOnly)
+		FCEU_PutImage();
 
 #ifdef WIN32
 	//These Windows only dialogs need to be updated only once per frame so they are included here
@@ -757,7 +790,9 @@ void FCEUI_Emulate(uint8 **pXBuf, int32 **SoundBuf, int32 *SoundBufSize, int ski
 	timestamp = 0;
 	soundtimestamp = 0;
 
-	*pXBuf = skip ? 0 : XBuf;
+	FCEU_DigestFrameEnd();
+
+	*pXBuf = (skip || computeOnly) ? 0 : XBuf;
 	if (skip == 2) { //If skip = 2, then bypass sound
 		*SoundBuf = 0;
 		*SoundBufSize = 0;
@@ -787,6 +822,24 @@ void FCEUI_Emulate(uint8 **pXBuf, int32 **SoundBuf, int32 *SoundBufSize, int ski
 		ProcessSubtitles();
 }
 
+// Runs one frame of the machine alone, for stepping a state that isn't on screen (see instance.cpp).
+// The ports keep the input they hold; input polling, the movie, Lua, autofire, autosave, the digest
+// log and the picture and sound output are all left out, and pausing doesn't apply.
+// Call it with compute-only mode on.
+void FCEU_EmulateCoreFrame(void) {
+	lagFlag = 1;
+	if (geniestage != 1) FCEU_ApplyPeriodicCheats();
+	FCEUPPU_Loop(2);
+
+	timestampbase += timestamp;
+	timestamp = 0;
+	soundtimestamp = 0;
+
+	if (lagFlag)
+		lagCounter++;
+	currFrameCounter++;
+}
+
 void FCEUI_CloseGame(void) {
 	if (!FCEU_IsValidUI(FCEUI_CLOSEGAME))
 		return;
@@ -14,6 +14,9 @@ extern bool skip_7bit_overclocking;
 extern int normalscanlines;
 extern int totalscanlines;
 extern int postrenderscanlines;
+
+//compute-only emulation, see FCEUI_SetComputeOnly
+extern bool computeOnly, computeSound;
 extern int vblankscanlines;
 
 extern bool AutoResumePlay;
@@ -32,6 +35,8 @@ int AllocGenieRW(void);
 void FlushGenieRW(void);
 
 void FCEU_ResetVidSys(void);
+void FCEU_RamSearchClose(void);
+void FCEU_EmulateCoreFrame(void);
 
 void ResetMapping(void);
 void ResetNES(void);
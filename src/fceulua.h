@@ -27,7 +27,19 @@ enum LuaMemHookType
 
 	LUAMEMHOOK_COUNT
 };
-void CallRegisteredLuaMemHook(unsigned int address, int size, unsigned int value, LuaMemHookType hookType);
+void CallRegisteredLuaMemHook_Dispatch(unsigned int address, int size, unsigned int value, LuaMemHookType hookType);
+
+// per-address bitmaps of hooked bytes, null for hook types without hooks
+extern unsigned int *luaMemHookBits[LUAMEMHOOK_COUNT];
+
+// performance critical! (called on every cpu write, and every instruction for exec hooks).
+// Unhooked accesses cost a load and a test, and nothing at all is called while no hooks are set.
+static inline void CallRegisteredLuaMemHook(unsigned int address, int size, unsigned int value, LuaMemHookType hookType)
+{
+	const unsigned int *bits = luaMemHookBits[hookType];
+	if(bits && (size != 1 || ((bits[address >> 5] >> (address & 31)) & 1)))
+		CallRegisteredLuaMemHook_Dispatch(address, size, value, hookType);
+}
 
 struct LuaSaveData
 {
@@ -79,6 +91,8 @@ int FCEU_LuaRerecordCountSkip();
 
 void FCEU_LuaGui(uint8 *XBuf);
 void FCEU_LuaUpdatePalette();
+void FCEU_LuaGuiSetRGBOverlay(bool enabled);
+const uint8 *FCEU_LuaGuiGetOverlay(int *firstLine, int *lastLine, const int **spanLeft, const int **spanRight);
 
 struct lua_State* FCEU_GetLuaState();
 char* FCEU_GetLuaScriptName();
@@ -79,6 +79,12 @@ static uint8 *diskdatao[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
 
 static uint8 *diskdata[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
 
+/* Blocks of each side that differ from diskdatao, so save states only need to carry those. */
+#define DISK_BLOCK_SHIFT	8
+#define DISK_BLOCKS			((65500 + (1 << DISK_BLOCK_SHIFT) - 1) >> DISK_BLOCK_SHIFT)
+static uint8 diskdirty[8][DISK_BLOCKS / 8];
+static bool diskStateRead = false;
+
 static int TotalSides; //mbg merge 7/17/06 - unsignedectomy
 static uint8 DiskWritten = 0;    /* Set to 1 if disk was written to. */
 static uint8 writeskip;
@@ -95,17 +101,110 @@ void FDSGI(GI h) {
 	}
 }
 
+static uint32 DiskBlockSize(int b) {
+	if (b == DISK_BLOCKS - 1)
+		return 65500 - (b << DISK_BLOCK_SHIFT);
+	return 1 << DISK_BLOCK_SHIFT;
+}
+
+static void MarkDirtyBlocks(void) {
+	int x, b;
+	for (x = 0; x < TotalSides; x++) {
+		memset(diskdirty[x], 0, sizeof(diskdirty[x]));
+		for (b = 0; b < DISK_BLOCKS; b++) {
+			uint32 ofs = b << DISK_BLOCK_SHIFT;
+			if (memcmp(diskdata[x] + ofs, diskdatao[x] + ofs, DiskBlockSize(b)))
+				diskdirty[x][b >> 3] |= 1 << (b & 7);
+		}
+	}
+}
+
 static void FDSStateRestore(int version) {
 	int x;
 
 	setmirror(((FDSRegs[5] & 8) >> 3) ^ 1);
 
-	if (version >= 9810)
+	/* Older save states carry every side XORed against the original image
+	   in their DDTx entries instead of a disk chunk. */
+	if (!diskStateRead && version >= 9810) {
 		for (x = 0; x < TotalSides; x++) {
 			int b;
 			for (b = 0; b < 65500; b++)
 				diskdata[x][b] ^= diskdatao[x][b];
 		}
+		MarkDirtyBlocks();
+	}
+	diskStateRead = false;
+}
+
+uint32 FDSDiskStateSize(void) {
+	uint32 size = TotalSides * sizeof(diskdirty[0]);
+	int x, b;
+	for (x = 0; x < TotalSides; x++)
+		for (b = 0; b < DISK_BLOCKS; b++)
+			if (diskdirty[x][b >> 3] & (1 << (b & 7)))
+				size += DiskBlockSize(b);
+	return size;
+}
+
+uint32 FDSDiskStateMaxSize(void) {
+	return TotalSides * (sizeof(diskdirty[0]) + 65500);
+}
+
+uint32 FDSSaveDiskState(uint8 *buf) {
+	uint8 *start = buf;
+	int x, b;
+	for (x = 0; x < TotalSides; x++) {
+		memcpy(buf, diskdirty[x], sizeof(diskdirty[x]));
+		buf += sizeof(diskdirty[x]);
+		for (b = 0; b < DISK_BLOCKS; b++)
+			if (diskdirty[x][b >> 3] & (1 << (b & 7))) {
+				memcpy(buf, diskdata[x] + (b << DISK_BLOCK_SHIFT), DiskBlockSize(b));
+				buf += DiskBlockSize(b);
+			}
+	}
+	return buf - start;
+}
+
+/* Called before the chunks of a state are read: whether this particular state
+   carried a disk chunk must not leak over from a load that failed halfway. */
+void FDSBeginStateLoad(void) {
+	diskStateRead = false;
+}
+
+bool FDSLoadDiskState(const uint8 *buf, uint32 size) {
+	uint32 need = 0;
+	const uint8 *p = buf;
+	int x, b;
+
+	/* Check that all the blocks are there before touching the disk. */
+	for (x = 0; x < TotalSides; x++) {
+		need += sizeof(diskdirty[x]);
+		if (need > size)
+			return false;
+		for (b = 0; b < DISK_BLOCKS; b++)
+			if (p[b >> 3] & (1 << (b & 7)))
+				need += DiskBlockSize(b);
+		p = buf + need;
+	}
+	if (need > size)
+		return false;
+
+	for (x = 0; x < TotalSides; x++) {
+		const uint8 *dirty = buf;
+		buf += sizeof(diskdirty[x]);
+		for (b = 0; b < DISK_BLOCKS; b++) {
+			uint32 ofs = b << DISK_BLOCK_SHIFT;
+			if (dirty[b >> 3] & (1 << (b & 7))) {
+				memcpy(diskdata[x] + ofs, buf, DiskBlockSize(b));
+				buf += DiskBlockSize(b);
+			} else if (diskdirty[x][b >> 3] & (1 << (b & 7)))
+				memcpy(diskdata[x] + ofs, diskdatao[x] + ofs, DiskBlockSize(b));
+		}
+		memcpy(diskdirty[x], dirty, sizeof(diskdirty[x]));
+	}
+	diskStateRead = true;
+	return true;
 }
 
 void FDSSound();
@@ -538,8 +637,10 @@ static DECLFW(FDSWrite) {
 				if (writeskip)
 					writeskip--;
 				else if (DiskPtr >= 2) {
+					int b = (DiskPtr - 2) >> DISK_BLOCK_SHIFT;
 					DiskWritten = 1;
 					diskdata[InDisk][DiskPtr - 2] = V;
+					diskdirty[InDisk][b >> 3] |= 1 << (b & 7);
 				}
 			}
 		}
@@ -616,24 +717,6 @@ static int SubLoad(FCEUFILE *fp) {
 	return(1);
 }
 
-static void PreSave(void) {
-	int x;
-	for (x = 0; x < TotalSides; x++) {
-		int b;
-		for (b = 0; b < 65500; b++)
-			diskdata[x][b] ^= diskdatao[x][b];
-	}
-}
-
-static void PostSave(void) {
-	int x;
-	for (x = 0; x < TotalSides; x++) {
-		int b;
-		for (b = 0; b < 65500; b++)
-			diskdata[x][b] ^= diskdatao[x][b];
-	}
-}
-
 int FDSLoad(const char *name, FCEUFILE *fp) {
 	FILE *zp;
 	int x;
@@ -693,16 +776,17 @@ int FDSLoad(const char *name, FCEUFILE *fp) {
 		return(0);
 	}
 
+	for (x = 0; x < TotalSides; x++) {
+		if (diskdatao[x])
+			free(diskdatao[x]);
+		diskdatao[x] = (uint8*)FCEU_malloc(65500);
+		memcpy(diskdatao[x], diskdata[x], 65500);
+	}
+
 	if (!disableBatteryLoading) {
 		FCEUFILE *tp;
 		char *fn = strdup(FCEU_MakeFName(FCEUMKF_FDS, 0, 0).c_str());
 
-		int x;
-		for (x = 0; x < TotalSides; x++) {
-			diskdatao[x] = (uint8*)FCEU_malloc(65500);
-			memcpy(diskdatao[x], diskdata[x], 65500);
-		}
-
 		if ((tp = FCEU_fopen(fn, 0, "rb", 0))) {
 			FCEU_printf("Disk was written. Auxillary FDS file open \"%s\".\n",fn);
 			FreeFDSMemory();
@@ -730,13 +814,17 @@ int FDSLoad(const char *name, FCEUFILE *fp) {
 	SelectDisk = 0;
 	InDisk = 255;
 
-	ResetExState(PreSave, PostSave);
+	MarkDirtyBlocks();
+	diskStateRead = false;
+
+	ResetExState(0, 0);
 	FDSSoundStateAdd();
 
+	/* Only read from older save states; the disk itself goes in its own chunk. */
 	for (x = 0; x < TotalSides; x++) {
 		char temp[5];
 		sprintf(temp, "DDT%d", x);
-		AddExState(diskdata[x], 65500, 0, temp);
+		AddExState(diskdata[x], 65500 | FCEUSTATE_LOADONLY, 0, temp);
 	}
 
 	AddExState(FDSRegs, sizeof(FDSRegs), 0, "FREG");
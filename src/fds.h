@@ -4,3 +4,10 @@ void FDSSoundReset(void);
 void FCEU_FDSInsert(void);
 //void FCEU_FDSEject(void);
 void FCEU_FDSSelect(void);
+
+//disk blocks changed since the image was loaded, as kept in savestates
+uint32 FDSDiskStateSize(void);
+uint32 FDSDiskStateMaxSize(void);
+uint32 FDSSaveDiskState(uint8 *buf);
+bool FDSLoadDiskState(const uint8 *buf, uint32 size);
+void FDSBeginStateLoad(void);
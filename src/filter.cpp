@@ -8,16 +8,33 @@
 #include "fceu.h"
 #include "filter.h"
 
-#include "fcoeffs.h"
-
 #include <cmath>
 #include <cstdio>
+#include <cstring>
 
-static int32 sq2coeffs[SQ2NCOEFFS];
-static int32 coeffs[NCOEFFS];
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
 
-static uint32 mrindex;
-static uint32 mrratio;
+/* High-quality sound is built from band-limited steps: every change of the
+   mixed output level is reported with the CPU cycle it happened on and is
+   spread over a few output samples using a windowed sinc kernel.  The
+   buffer holds the differences of the output waveform, so reading it back
+   is a running sum.
+*/
+#define BL_PHASE_BITS 5
+#define BL_PHASES (1<<BL_PHASE_BITS)
+#define BL_INTERP_BITS 15
+#define BL_MAXWIDTH 32
+#define BL_KERNEL_BITS 15
+#define BL_BUFSIZE 4096	/* Enough for 40000 cycles at 96KHz. */
+
+static int32 blkernel[BL_PHASES+1][BL_MAXWIDTH];
+static uint32 blwidth;
+static int32 blbuf[BL_BUFSIZE+BL_MAXWIDTH];
+static uint64 blfactor;		/* Output samples per CPU cycle, 32.32 fixed point. */
+static uint64 bloffset;		/* Fractional sample left over from the last frame. */
+static int64 blaccum;
 
 void SexyFilter2(int32 *in, int32 count)
 {
@@ -81,129 +98,110 @@ void SexyFilter(int32 *in, int32 *out, int32 count)
  }
 }
 
-/* Returns number of samples written to out. */
-/* leftover is set to the number of samples that need to be copied
-   from the end of in to the beginning of in.
-*/
-
-//static uint32 mva=1000;
+void BandLimitedStep(uint32 ts, int32 delta)
+{
+ uint64 t=bloffset+(uint64)ts*blfactor;
+ int32 *out=&blbuf[(uint32)(t>>32)];
+ uint32 phase=(uint32)(t>>(32-BL_PHASE_BITS))&(BL_PHASES-1);
+ int32 interp=(int32)(t>>(32-BL_PHASE_BITS-BL_INTERP_BITS))&((1<<BL_INTERP_BITS)-1);
+ int32 d1=(int32)(((int64)delta*interp)>>BL_INTERP_BITS);
+ int32 d0=delta-d1;
+ const int32 *k0=blkernel[phase];
+ const int32 *k1=blkernel[phase+1];
+ uint32 x;
+
+ for(x=0;x<blwidth;x++)
+  out[x]+=k0[x]*d0+k1[x]*d1;
+}
 
-/* This filtering code assumes that almost all input values stay below 32767.
-   Do not adjust the volume in the wlookup tables and the expansion sound
-   code to be higher, or you *might* overflow the FIR code.
+/* Returns number of samples written to out.  Steps that fall after the
+   last complete sample stay in the buffer for the next call.
 */
-
-int32 NeoFilterSound(int32 *in, int32 *out, uint32 inlen, int32 *leftover)
+int32 BandLimitedSound(int32 *out, uint32 inlen)
 {
-	uint32 x;
-	uint32 max;
-	int32 *outsave=out;
-	int32 count=0;
-
-//	for(x=0;x<inlen;x++)
-//	{
-//	 if(in[x]>mva){ mva=in[x]; printf("%ld\n",in[x]);}
-//	}
-        max=(inlen-1)<<16;
-
-	if(FSettings.soundq==2)
-        for(x=mrindex;x<max;x+=mrratio)
-        {
-			int32 acc=0,acc2=0;
-			unsigned int c;
-			int32 *S,*D;
-
-			for(c=SQ2NCOEFFS,S=&in[(x>>16)-SQ2NCOEFFS],D=sq2coeffs;c;c--,D++)
-			{
-				acc+=(S[c]**D)>>6;
-				acc2+=(S[1+c]**D)>>6;
-			}
-
-			acc=((int64)acc*(65536-(x&65535))+(int64)acc2*(x&65535))>>(16+11);
-			*out=acc;
-			out++;
-			count++;
-        }
-	else
-		for(x=mrindex;x<max;x+=mrratio)
-		{
-			int32 acc=0,acc2=0;
-			unsigned int c;
-			const int32 *S,*D;
-
-			for(c=NCOEFFS,S=&in[(x>>16)-NCOEFFS],D=coeffs;c;c--,D++)
-			{
-				acc+=(S[c]**D)>>6;
-				acc2+=(S[1+c]**D)>>6;
-			}
-
-			acc=((int64)acc*(65536-(x&65535))+(int64)acc2*(x&65535))>>(16+11);
-			*out=acc;
-			out++;
-			count++;
-		}
-
-	mrindex=x-max;
-
-	if(FSettings.soundq==2)
-	{
-         mrindex+=SQ2NCOEFFS*65536;
-         *leftover=SQ2NCOEFFS+1;
-	}
-	else
+	uint64 t=bloffset+(uint64)inlen*blfactor;
+	int32 count=(int32)(t>>32);
+	int32 x;
+
+	for(x=0;x<count;x++)
 	{
-         mrindex+=NCOEFFS*65536;
-         *leftover=NCOEFFS+1;
+		blaccum+=blbuf[x];
+		out[x]=(int32)(blaccum>>(BL_KERNEL_BITS-3));	/* Same gain as the old FIR code. */
 	}
+	memmove(blbuf,blbuf+count,(BL_BUFSIZE+BL_MAXWIDTH-count)*sizeof(int32));
+	memset(blbuf+BL_BUFSIZE+BL_MAXWIDTH-count,0,count*sizeof(int32));
+	bloffset=t&0xFFFFFFFF;
 
 	if(GameExpSound.NeoFill)
-	 GameExpSound.NeoFill(outsave,count);
+	 GameExpSound.NeoFill(out,count);
 
-	SexyFilter(outsave,outsave,count);
+	SexyFilter(out,out,count);
 	if(FSettings.lowpass)
-	 SexyFilter2(outsave,count);
+	 SexyFilter2(out,count);
 	return(count);
 }
 
-void MakeFilters(int32 rate)
+void BandLimitedReset(void)
 {
- const int32 *tabs[6]={C44100NTSC,C44100PAL,C48000NTSC,C48000PAL,C96000NTSC,
-        C96000PAL};
- const int32 *sq2tabs[6]={SQ2C44100NTSC,SQ2C44100PAL,SQ2C48000NTSC,SQ2C48000PAL,
-	SQ2C96000NTSC,SQ2C96000PAL};
-
- const int32 *tmp;
- int32 x;
- uint32 nco;
-
- if(FSettings.soundq==2)
-  nco=SQ2NCOEFFS;
- else
-  nco=NCOEFFS;
+ memset(blbuf,0,sizeof(blbuf));
+ bloffset=0;
+ blaccum=0;
+}
 
- mrindex=(nco+1)<<16;
- mrratio=(PAL?(int64)(PAL_CPU*65536):(int64)(NTSC_CPU*65536))/rate;
+void MakeFilters(int32 rate)
+{
+ double cutoff;
+ uint32 p,x;
 
  if(FSettings.soundq==2)
-  tmp=sq2tabs[(PAL?1:0)|(rate==48000?2:0)|(rate==96000?4:0)];
+ {
+  blwidth=32;
+  cutoff=0.45;
+ }
  else
-  tmp=tabs[(PAL?1:0)|(rate==48000?2:0)|(rate==96000?4:0)];
+ {
+  blwidth=16;
+  cutoff=0.40;
+ }
 
- if(FSettings.soundq==2)
-  for(x=0;x<SQ2NCOEFFS>>1;x++)
-   sq2coeffs[x]=sq2coeffs[SQ2NCOEFFS-1-x]=tmp[x];
- else
-  for(x=0;x<NCOEFFS>>1;x++)
-   coeffs[x]=coeffs[NCOEFFS-1-x]=tmp[x];
+ blfactor=(uint64)((double)rate*4294967296.0/(PAL?PAL_CPU:NTSC_CPU));
 
- #ifdef MOO
- /* Some tests involving precision and error. */
+ /* Row p holds the impulse for a step p/BL_PHASES of a sample late.  Each
+    row sums to exactly 1<<BL_KERNEL_BITS so that steps never leave a
+    DC error behind when the buffer is integrated.
+ */
+ for(p=0;p<=BL_PHASES;p++)
  {
-  static int64 acc=0;
-  int x;
-  for(x=0;x<SQ2NCOEFFS;x++)
-   acc+=(int64)32767*sq2coeffs[x];
-  printf("Foo: %lld\n",acc);
+  double h[BL_MAXWIDTH];
+  double sum=0;
+  int32 isum=0;
+  uint32 peak=0;
+
+  for(x=0;x<blwidth;x++)
+  {
+   double t=(double)x-(blwidth/2-1)-(double)p/BL_PHASES;
+   double w=0;
+
+   if(fabs(t)<blwidth/2)
+    w=0.42+0.5*cos(2*M_PI*t/blwidth)+0.08*cos(4*M_PI*t/blwidth);
+   if(t==0)
+    h[x]=2*cutoff;
+   else
+    h[x]=sin(2*M_PI*cutoff*t)/(M_PI*t);
+   h[x]*=w;
+   sum+=h[x];
+  }
+  for(x=0;x<blwidth;x++)
+  {
+   blkernel[p][x]=(int32)floor(h[x]*(1<<BL_KERNEL_BITS)/sum+0.5);
+   isum+=blkernel[p][x];
+   if(blkernel[p][x]>blkernel[p][peak])
+    peak=x;
+  }
+  blkernel[p][peak]+=(1<<BL_KERNEL_BITS)-isum;
+  for(;x<BL_MAXWIDTH;x++)
+   blkernel[p][x]=0;
  }
- #endif
+
+ BandLimitedReset();
 }
@@ -1,3 +1,5 @@
-int32 NeoFilterSound(int32 *in, int32 *out, uint32 inlen, int32 *leftover);
+void BandLimitedStep(uint32 ts, int32 delta);
+int32 BandLimitedSound(int32 *out, uint32 inlen);
+void BandLimitedReset(void);
 void MakeFilters(int32 rate);
 void SexyFilter(int32 *in, int32 *out, int32 count);
@@ -1,512 +0,0 @@
-116,
-9,
-9,
-10,
-10,
-10,
-10,
-10,
-10,
-10,
-10,
-9,
-9,
-8,
-8,
-7,
-6,
-5,
-4,
-3,
-2,
-1,
-0,
--1,
--2,
--4,
--5,
--7,
--9,
--10,
--12,
--14,
--16,
--18,
--20,
--22,
--24,
--25,
--27,
--29,
--31,
--33,
--34,
--36,
--37,
--39,
--40,
--41,
--42,
--43,
--44,
--44,
--44,
--45,
--45,
--44,
--44,
--43,
--42,
--41,
--40,
--39,
--37,
--35,
--33,
--30,
--28,
--25,
--22,
--18,
--15,
--11,
--7,
--3,
-0,
-4,
-9,
-13,
-18,
-22,
-27,
-32,
-36,
-41,
-46,
-50,
-55,
-59,
-64,
-68,
-72,
-76,
-79,
-82,
-85,
-88,
-91,
-93,
-94,
-96,
-97,
-97,
-97,
-97,
-96,
-95,
-93,
-91,
-88,
-85,
-81,
-77,
-73,
-68,
-62,
-56,
-50,
-43,
-36,
-28,
-20,
-12,
-4,
--4,
--13,
--22,
--32,
--41,
--51,
--60,
--70,
--79,
--89,
--98,
--107,
--116,
--125,
--133,
--141,
--148,
--155,
--162,
--168,
--173,
--178,
--182,
--186,
--188,
--190,
--192,
--192,
--191,
--190,
--188,
--185,
--181,
--176,
--170,
--163,
--156,
--147,
--138,
--128,
--117,
--105,
--93,
--79,
--66,
--51,
--36,
--20,
--4,
-11,
-28,
-45,
-63,
-80,
-98,
-115,
-133,
-150,
-167,
-183,
-200,
-215,
-231,
-245,
-259,
-272,
-284,
-295,
-305,
-314,
-322,
-328,
-334,
-338,
-340,
-341,
-341,
-339,
-336,
-331,
-324,
-316,
-307,
-296,
-283,
-269,
-253,
-236,
-218,
-198,
-176,
-154,
-131,
-106,
-80,
-54,
-26,
--1,
--29,
--58,
--88,
--117,
--147,
--177,
--207,
--236,
--265,
--294,
--321,
--348,
--374,
--399,
--423,
--445,
--466,
--486,
--503,
--519,
--533,
--545,
--554,
--562,
--567,
--570,
--570,
--568,
--564,
--557,
--547,
--535,
--520,
--503,
--483,
--461,
--436,
--409,
--379,
--347,
--314,
--278,
--240,
--200,
--159,
--117,
--72,
--27,
-18,
-65,
-113,
-161,
-210,
-258,
-306,
-354,
-402,
-448,
-494,
-538,
-581,
-622,
-661,
-698,
-733,
-765,
-795,
-822,
-846,
-866,
-883,
-897,
-907,
-914,
-916,
-915,
-910,
-901,
-887,
-870,
-848,
-823,
-793,
-759,
-722,
-680,
-635,
-587,
-534,
-479,
-420,
-359,
-295,
-228,
-159,
-88,
-15,
--58,
--134,
--210,
--287,
--364,
--441,
--518,
--593,
--668,
--741,
--813,
--882,
--949,
--1013,
--1074,
--1131,
--1185,
--1235,
--1280,
--1321,
--1357,
--1387,
--1412,
--1432,
--1446,
--1454,
--1456,
--1451,
--1440,
--1423,
--1400,
--1370,
--1333,
--1290,
--1241,
--1185,
--1123,
--1055,
--981,
--901,
--816,
--726,
--631,
--531,
--427,
--319,
--208,
--93,
-24,
-143,
-265,
-388,
-511,
-635,
-759,
-882,
-1004,
-1124,
-1242,
-1357,
-1468,
-1575,
-1678,
-1776,
-1868,
-1955,
-2034,
-2107,
-2172,
-2229,
-2278,
-2318,
-2349,
-2370,
-2382,
-2384,
-2376,
-2357,
-2327,
-2287,
-2237,
-2175,
-2103,
-2020,
-1926,
-1822,
-1708,
-1583,
-1449,
-1306,
-1153,
-992,
-822,
-645,
-461,
-270,
-74,
--127,
--333,
--543,
--757,
--972,
--1189,
--1406,
--1623,
--1839,
--2052,
--2263,
--2469,
--2670,
--2866,
--3055,
--3235,
--3407,
--3569,
--3721,
--3861,
--3988,
--4102,
--4201,
--4286,
--4355,
--4407,
--4441,
--4458,
--4456,
--4434,
--4393,
--4331,
--4249,
--4145,
--4020,
--3873,
--3704,
--3512,
--3299,
--3063,
--2806,
--2526,
--2224,
--1900,
--1556,
--1190,
--804,
--398,
-27,
-471,
-933,
-1412,
-1908,
-2419,
-2945,
-3484,
-4036,
-4599,
-5172,
-5754,
-6344,
-6940,
-7541,
-8146,
-8754,
-9363,
-9971,
-10578,
-11182,
-11781,
-12374,
-12959,
-13536,
-14103,
-14658,
-15199,
-15727,
-16239,
-16734,
-17211,
-17669,
-18106,
-18521,
-18914,
-19283,
-19627,
-19946,
-20239,
-20505,
-20743,
-20952,
-21133,
-21284,
-21405,
-21497,
-21558,
-21588,
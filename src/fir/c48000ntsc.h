@@ -1,512 +0,0 @@
--115,
--12,
--13,
--14,
--14,
--14,
--15,
--15,
--15,
--15,
--15,
--15,
--15,
--15,
--14,
--14,
--13,
--12,
--11,
--10,
--9,
--8,
--7,
--5,
--3,
--2,
-0,
-1,
-3,
-5,
-7,
-10,
-12,
-14,
-17,
-19,
-22,
-24,
-26,
-29,
-31,
-33,
-35,
-37,
-39,
-41,
-42,
-44,
-45,
-46,
-47,
-48,
-48,
-48,
-48,
-48,
-47,
-47,
-45,
-44,
-42,
-40,
-38,
-35,
-33,
-30,
-26,
-23,
-19,
-15,
-10,
-6,
-1,
--3,
--8,
--13,
--18,
--23,
--28,
--33,
--39,
--44,
--49,
--54,
--59,
--63,
--68,
--72,
--76,
--80,
--83,
--86,
--88,
--91,
--92,
--94,
--94,
--95,
--94,
--93,
--92,
--90,
--88,
--85,
--81,
--77,
--73,
--67,
--62,
--55,
--49,
--42,
--34,
--26,
--18,
--9,
-0,
-9,
-18,
-28,
-38,
-48,
-57,
-67,
-77,
-87,
-96,
-106,
-114,
-123,
-131,
-139,
-146,
-152,
-158,
-163,
-168,
-171,
-174,
-176,
-177,
-177,
-177,
-175,
-172,
-168,
-164,
-158,
-151,
-143,
-135,
-125,
-115,
-103,
-91,
-78,
-65,
-50,
-35,
-20,
-3,
--12,
--29,
--46,
--63,
--80,
--98,
--115,
--132,
--148,
--165,
--180,
--196,
--210,
--224,
--237,
--248,
--259,
--269,
--277,
--285,
--290,
--295,
--298,
--299,
--299,
--297,
--294,
--289,
--282,
--274,
--264,
--252,
--239,
--224,
--208,
--190,
--171,
--151,
--129,
--106,
--82,
--57,
--31,
--5,
-22,
-49,
-77,
-105,
-134,
-162,
-190,
-217,
-244,
-270,
-295,
-320,
-343,
-365,
-385,
-404,
-421,
-436,
-449,
-460,
-469,
-475,
-479,
-481,
-480,
-477,
-471,
-462,
-451,
-437,
-421,
-402,
-380,
-357,
-330,
-302,
-271,
-238,
-203,
-167,
-129,
-89,
-48,
-6,
--35,
--79,
--123,
--167,
--211,
--255,
--298,
--341,
--383,
--423,
--462,
--500,
--535,
--569,
--600,
--628,
--654,
--677,
--697,
--713,
--726,
--735,
--741,
--743,
--741,
--735,
--725,
--711,
--693,
--671,
--645,
--616,
--582,
--545,
--504,
--459,
--412,
--361,
--307,
--251,
--192,
--132,
--69,
--5,
-60,
-126,
-193,
-260,
-328,
-394,
-460,
-525,
-588,
-650,
-709,
-765,
-819,
-869,
-916,
-958,
-997,
-1031,
-1060,
-1084,
-1103,
-1116,
-1124,
-1126,
-1123,
-1113,
-1097,
-1075,
-1047,
-1013,
-973,
-928,
-876,
-819,
-756,
-689,
-616,
-539,
-457,
-372,
-283,
-190,
-95,
--1,
--100,
--201,
--302,
--404,
--506,
--607,
--706,
--804,
--900,
--993,
--1082,
--1167,
--1248,
--1324,
--1395,
--1459,
--1517,
--1569,
--1613,
--1649,
--1678,
--1698,
--1710,
--1713,
--1707,
--1692,
--1667,
--1634,
--1591,
--1539,
--1478,
--1408,
--1329,
--1242,
--1146,
--1043,
--931,
--813,
--688,
--556,
--419,
--277,
--131,
-19,
-172,
-328,
-485,
-643,
-801,
-958,
-1113,
-1266,
-1416,
-1561,
-1702,
-1836,
-1964,
-2085,
-2197,
-2300,
-2393,
-2476,
-2548,
-2608,
-2656,
-2690,
-2712,
-2720,
-2713,
-2692,
-2657,
-2607,
-2542,
-2462,
-2367,
-2257,
-2133,
-1994,
-1842,
-1676,
-1497,
-1305,
-1102,
-888,
-663,
-430,
-187,
--61,
--317,
--579,
--844,
--1113,
--1383,
--1653,
--1922,
--2189,
--2452,
--2709,
--2960,
--3203,
--3437,
--3659,
--3869,
--4065,
--4245,
--4409,
--4556,
--4682,
--4789,
--4873,
--4935,
--4973,
--4986,
--4972,
--4933,
--4865,
--4770,
--4646,
--4492,
--4309,
--4096,
--3853,
--3579,
--3276,
--2942,
--2578,
--2185,
--1763,
--1313,
--835,
--330,
-200,
-755,
-1335,
-1937,
-2560,
-3203,
-3864,
-4543,
-5236,
-5942,
-6660,
-7387,
-8122,
-8863,
-9608,
-10354,
-11099,
-11842,
-12580,
-13311,
-14033,
-14745,
-15443,
-16125,
-16791,
-17436,
-18061,
-18663,
-19239,
-19789,
-20310,
-20801,
-21261,
-21687,
-22079,
-22435,
-22755,
-23037,
-23281,
-23485,
-23649,
-23772,
-23854,
-23896,
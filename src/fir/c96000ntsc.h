@@ -1,512 +0,0 @@
-0,
-0,
-0,
-0,
-0,
-0,
-0,
-0,
-0,
-0,
-0,
-0,
-0,
-0,
-0,
-0,
-0,
-0,
-0,
-0,
-0,
-0,
-0,
-0,
-0,
-0,
-1,
-1,
-1,
-1,
-1,
-1,
-1,
-1,
-1,
-1,
-1,
-1,
-0,
-0,
-0,
-0,
-0,
-0,
--1,
--1,
--2,
--2,
--2,
--3,
--3,
--3,
--3,
--3,
--3,
--3,
--3,
--3,
--2,
--2,
--1,
--1,
-0,
-0,
-1,
-2,
-3,
-4,
-4,
-5,
-6,
-6,
-7,
-7,
-7,
-7,
-7,
-7,
-6,
-6,
-5,
-4,
-2,
-1,
-0,
--1,
--3,
--5,
--6,
--8,
--10,
--11,
--12,
--13,
--14,
--14,
--14,
--14,
--14,
--13,
--11,
--10,
--8,
--6,
--3,
-0,
-1,
-4,
-7,
-10,
-13,
-16,
-18,
-21,
-22,
-24,
-25,
-25,
-25,
-24,
-23,
-21,
-18,
-15,
-12,
-8,
-3,
--1,
--6,
--11,
--16,
--20,
--25,
--29,
--33,
--36,
--39,
--41,
--42,
--42,
--41,
--39,
--36,
--32,
--27,
--22,
--15,
--8,
--1,
-6,
-14,
-22,
-30,
-37,
-44,
-51,
-56,
-60,
-64,
-65,
-66,
-65,
-62,
-58,
-53,
-46,
-38,
-28,
-18,
-6,
--4,
--17,
--29,
--41,
--53,
--64,
--74,
--83,
--90,
--95,
--99,
--100,
--100,
--97,
--91,
--84,
--74,
--62,
--49,
--33,
--17,
-0,
-18,
-36,
-55,
-72,
-89,
-104,
-118,
-129,
-138,
-144,
-148,
-148,
-144,
-138,
-128,
-114,
-98,
-79,
-58,
-34,
-9,
--16,
--42,
--69,
--95,
--120,
--143,
--163,
--181,
--195,
--205,
--211,
--212,
--209,
--201,
--188,
--171,
--149,
--124,
--94,
--62,
--27,
-8,
-46,
-84,
-121,
-156,
-189,
-219,
-245,
-267,
-283,
-294,
-298,
-295,
-287,
-271,
-249,
-221,
-187,
-148,
-104,
-57,
-7,
--44,
--96,
--148,
--198,
--245,
--288,
--326,
--358,
--382,
--400,
--408,
--408,
--399,
--381,
--354,
--318,
--274,
--223,
--165,
--102,
--35,
-34,
-105,
-175,
-244,
-309,
-370,
-424,
-470,
-507,
-533,
-549,
-553,
-545,
-524,
-492,
-447,
-392,
-326,
-252,
-169,
-81,
--10,
--105,
--200,
--293,
--383,
--466,
--541,
--606,
--660,
--700,
--726,
--737,
--732,
--710,
--672,
--619,
--550,
--467,
--372,
--266,
--152,
--31,
-93,
-219,
-344,
-464,
-577,
-680,
-771,
-847,
-907,
-948,
-970,
-970,
-949,
-907,
-843,
-760,
-657,
-537,
-403,
-256,
-99,
--62,
--228,
--392,
--552,
--704,
--845,
--970,
--1077,
--1164,
--1226,
--1264,
--1274,
--1257,
--1211,
--1138,
--1038,
--912,
--763,
--593,
--407,
--206,
-3,
-219,
-435,
-647,
-851,
-1040,
-1212,
-1361,
-1484,
-1578,
-1639,
-1666,
-1656,
-1610,
-1528,
-1409,
-1257,
-1073,
-860,
-623,
-367,
-95,
--184,
--468,
--749,
--1020,
--1277,
--1512,
--1719,
--1894,
--2033,
--2130,
--2182,
--2188,
--2146,
--2056,
--1918,
--1734,
--1507,
--1240,
--939,
--610,
--257,
-109,
-484,
-859,
-1225,
-1574,
-1898,
-2190,
-2441,
-2646,
-2798,
-2893,
-2926,
-2897,
-2802,
-2643,
-2421,
-2140,
-1803,
-1416,
-986,
-522,
-32,
--472,
--983,
--1487,
--1974,
--2433,
--2853,
--3223,
--3534,
--3777,
--3944,
--4030,
--4029,
--3940,
--3760,
--3492,
--3137,
--2701,
--2189,
--1611,
--977,
--298,
-411,
-1139,
-1868,
-2584,
-3270,
-3910,
-4489,
-4991,
-5404,
-5713,
-5909,
-5982,
-5926,
-5735,
-5409,
-4948,
-4356,
-3639,
-2808,
-1873,
-851,
--241,
--1385,
--2559,
--3738,
--4899,
--6016,
--7064,
--8015,
--8845,
--9529,
--10043,
--10366,
--10479,
--10363,
--10006,
--9397,
--8529,
--7398,
--6005,
--4355,
--2456,
--320,
-2033,
-4587,
-7316,
-10193,
-13188,
-16268,
-19400,
-22548,
-25673,
-28740,
-31710,
-34547,
-37216,
-39683,
-41916,
-43887,
-45570,
-46943,
-47990,
-48695,
-49050,
@@ -41,6 +41,8 @@
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <vector>
+#include <algorithm>
 
 extern SFORMAT FCEUVSUNI_STATEINFO[];
 
@@ -726,8 +728,88 @@ static BMAPPINGLocal bmap[] = {
 	{"",					0, NULL}
 };
 
+//works out the mapper and the PRG/CHR layout of an iNES image from its (cleaned up) header.
+//sizes are in 16KiB/8KiB units; prgread is how much PRG is actually stored in the file
+static int iNESLayout(const iNES_HEADER *h, uint32 *prgsize, uint32 *chrsize, uint32 *prgread) {
+	bool ines2 = ((h->ROM_type2 & 0x0C) == 0x08);
+
+	int mapper = (h->ROM_type >> 4);
+	mapper |= (h->ROM_type2 & 0xF0);
+	if(ines2) mapper |= ((h->ROM_type3 & 0x0F) << 8);
+
+	int not_round_size = h->ROM_size;
+	if(ines2) not_round_size |= ((h->Upper_ROM_VROM_size & 0x0F) << 8);
+
+	if (!h->ROM_size && !ines2)
+		*prgsize = 256;
+	else
+		*prgsize = uppow2(not_round_size);
+
+	*chrsize = uppow2(h->VROM_size | (ines2?((h->Upper_ROM_VROM_size & 0xF0)<<4):0));
+
+	*prgread = *prgsize;
+	for (int i = 0; i != sizeof(not_power2) / sizeof(not_power2[0]); ++i) {
+		//for games not to the power of 2, so we just read enough
+		//prg rom from it, but we have to keep ROM_size to the power of 2
+		//since PRGCartMapping wants ROM_size to be to the power of 2
+		//so instead if not to power of 2, we just use head.ROM_size when
+		//we use FCEU_read
+		if (not_power2[i] == mapper) {
+			*prgread = not_round_size;
+			break;
+		}
+	}
+
+	return mapper;
+}
+
+//computes the same CRC32/MD5 that iNESLoad would report for an in-memory image,
+//without touching any emulator state. returns the mapper number, or -1 if it isn't an iNES image.
+int iNESHashImage(const uint8 *data, uint32 size, uint32 *crc32, uint8 md5out[16]) {
+	iNES_HEADER h;
+	uint32 prgsize, chrsize, prgread;
+
+	if (size < 16 || memcmp(data, "NES\x1a", 4))
+		return -1;
+
+	memcpy(&h, data, 16);
+	h.cleanup();
+
+	int mapper = iNESLayout(&h, &prgsize, &chrsize, &prgread);
+
+	uint32 pos = 16;
+	if (h.ROM_type & 4)	/* Trainer */
+		pos += 512;
+	if (pos > size)
+		pos = size;
+
+	//pad with 0xFF and take whatever is there, exactly like the FCEU_fread calls in iNESLoad
+	std::vector<uint8> prg(prgsize << 14, 0xFF);
+	uint32 len = std::min(prgread << 14, size - pos);
+	memcpy(&prg[0], data + pos, len);
+	pos += len;
+
+	md5_context md5;
+	md5_starts(&md5);
+	md5_update(&md5, &prg[0], prgsize << 14);
+	*crc32 = CalcCRC32(0, &prg[0], prgsize << 14);
+
+	if (chrsize) {
+		std::vector<uint8> chr(chrsize << 13, 0xFF);
+		len = std::min(chrsize << 13, size - pos);
+		if (len)
+			memcpy(&chr[0], data + pos, len);
+		*crc32 = CalcCRC32(*crc32, &chr[0], chrsize << 13);
+		md5_update(&md5, &chr[0], chrsize << 13);
+	}
+	md5_finish(&md5, md5out);
+
+	return mapper;
+}
+
 int iNESLoad(const char *name, FCEUFILE *fp, int OverwriteVidMode) {
 	struct md5_context md5;
+	uint32 prgread;
 
 	if (FCEU_fread(&head, 1, 16, fp) != 16)
 		return 0;
@@ -750,38 +832,13 @@ int iNESLoad(const char *name, FCEUFILE *fp, int OverwriteVidMode) {
 		iNESCart.submapper = head.ROM_type3 >> 4;
 	}
 
-	MapperNo = (head.ROM_type >> 4);
-	MapperNo |= (head.ROM_type2 & 0xF0);
-	if(iNES2) MapperNo |= ((head.ROM_type3 & 0x0F) << 8);
+	MapperNo = iNESLayout(&head, &ROM_size, &VROM_size, &prgread);
 	
 	if (head.ROM_type & 8) {
 		Mirroring = 2;
 	} else
 		Mirroring = (head.ROM_type & 1);
 
-	int not_round_size = head.ROM_size;
-	if(iNES2) not_round_size |= ((head.Upper_ROM_VROM_size & 0x0F) << 8);
-	
-	if (!head.ROM_size && !iNES2)
-		ROM_size = 256;
-	else
-		ROM_size = uppow2(not_round_size);
-
-	VROM_size = uppow2(head.VROM_size | (iNES2?((head.Upper_ROM_VROM_size & 0xF0)<<4):0));
-
-	int round = true;
-	for (int i = 0; i != sizeof(not_power2) / sizeof(not_power2[0]); ++i) {
-		//for games not to the power of 2, so we just read enough
-		//prg rom from it, but we have to keep ROM_size to the power of 2
-		//since PRGCartMapping wants ROM_size to be to the power of 2
-		//so instead if not to power of 2, we just use head.ROM_size when
-		//we use FCEU_read
-		if (not_power2[i] == MapperNo) {
-			round = false;
-			break;
-		}
-	}
-
 	if ((ROM = (uint8*)FCEU_malloc(ROM_size << 14)) == NULL)
 		return 0;
 	memset(ROM, 0xFF, ROM_size << 14);
@@ -805,7 +862,7 @@ int iNESLoad(const char *name, FCEUFILE *fp, int OverwriteVidMode) {
 
 	SetupCartPRGMapping(0, ROM, ROM_size << 14, 0);
 
-	FCEU_fread(ROM, 0x4000, (round) ? ROM_size : not_round_size, fp);
+	FCEU_fread(ROM, 0x4000, prgread, fp);
 
 	if (VROM_size)
 		FCEU_fread(VROM, 0x2000, VROM_size, fp);
@@ -824,7 +881,7 @@ int iNESLoad(const char *name, FCEUFILE *fp, int OverwriteVidMode) {
 
 	iNESCart.CRC32 = iNESGameCRC32;
 
-	FCEU_printf(" PRG ROM:  %3d x 16KiB\n", (round) ? ROM_size: not_round_size);
+	FCEU_printf(" PRG ROM:  %3d x 16KiB\n", prgread);
 	FCEU_printf(" CHR ROM:  %3d x  8KiB\n", head.VROM_size);
 	FCEU_printf(" ROM CRC32:  0x%08lx\n", iNESGameCRC32);
 	{
@@ -48,6 +48,7 @@ extern int iNesSaveAs(char* name);
 extern char LoadedRomFName[2048]; //bbit Edited: line added
 extern const TMasterRomInfo* MasterRomInfo;
 extern TMasterRomInfoParams MasterRomInfoParams;
+int iNESHashImage(const uint8 *data, uint32 size, uint32 *crc32, uint8 md5[16]);
 
 //mbg merge 7/19/06 changed to c++ decl format
 struct iNES_HEADER {
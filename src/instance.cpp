@@ -0,0 +1,135 @@
+#include "types.h"
+#include "fceu.h"
+#include "driver.h"
+#include "state.h"
+#include "movie.h"
+#include "instance.h"
+
+#include <vector>
+
+struct FCEUInstance
+{
+	std::vector<uint8> state;
+};
+
+// indexed by handle; freed handles are NULL and get reused
+static std::vector<FCEUInstance*> instances;
+static int liveInstance = 0;
+
+static bool CanSwitch(void)
+{
+	if (!GameInfo)
+		return false;
+	if (!FCEUMOV_Mode(MOVIEMODE_INACTIVE))
+	{
+		FCEU_PrintError("Emulator instances can't be switched while a movie is active.");
+		return false;
+	}
+	return true;
+}
+
+static void StoreLive(FCEUInstance *inst)
+{
+	inst->state.resize(FCEUSS_RawSize());
+	FCEUSS_RawSave(&inst->state[0], inst->state.size());
+}
+
+static bool LoadLive(FCEUInstance *inst)
+{
+	return !inst->state.empty() && FCEUSS_RawLoad(&inst->state[0], inst->state.size());
+}
+
+int FCEUI_CreateInstance(void)
+{
+	if (!CanSwitch())
+		return -1;
+
+	if (instances.empty())
+	{
+		instances.push_back(new FCEUInstance());
+		liveInstance = 0;
+	}
+
+	int id = 0;
+	while (id < (int)instances.size() && instances[id])
+		id++;
+	if (id == (int)instances.size())
+		instances.push_back(0);
+
+	FCEUInstance *inst = new FCEUInstance();
+	StoreLive(inst);
+	instances[id] = inst;
+	return id;
+}
+
+bool FCEUI_SelectInstance(int id)
+{
+	if (id == liveInstance)
+		return true;
+	if (id < 0 || id >= (int)instances.size() || !instances[id] || !CanSwitch())
+		return false;
+
+	StoreLive(instances[liveInstance]);
+	if (!LoadLive(instances[id]))
+	{
+		LoadLive(instances[liveInstance]);
+		return false;
+	}
+	liveInstance = id;
+	return true;
+}
+
+void FCEUI_DestroyInstance(int id)
+{
+	if (id == liveInstance || id < 0 || id >= (int)instances.size())
+		return;
+	delete instances[id];
+	instances[id] = 0;
+}
+
+int FCEUI_GetInstance(void)
+{
+	return liveInstance;
+}
+
+int FCEUI_GetInstanceCount(void)
+{
+	int count = 0;
+	for (size_t i = 0; i < instances.size(); i++)
+		if (instances[i])
+			count++;
+	return count ? count : 1;
+}
+
+void FCEUI_EmulateInstances(int frames)
+{
+	if (!CanSwitch())
+		return;
+
+	int home = liveInstance;
+	bool wasComputeOnly = computeOnly, wasComputeSound = computeSound;
+
+	FCEUI_SetComputeOnly(true);
+	for (size_t i = 0; i < instances.size(); i++)
+	{
+		if (!instances[i] || !FCEUI_SelectInstance(i))
+			continue;
+		for (int f = 0; f < frames; f++)
+			FCEU_EmulateCoreFrame();
+	}
+	if (instances.empty())
+	{
+		for (int f = 0; f < frames; f++)
+			FCEU_EmulateCoreFrame();
+	}
+	FCEUI_SetComputeOnly(wasComputeOnly, wasComputeSound);
+	FCEUI_SelectInstance(home);
+}
+
+void FCEU_CloseInstances(void)
+{
+	for (size_t i = 0; i < instances.size(); i++)
+		delete instances[i];
+	instances.clear();
+	liveInstance = 0;
+}
@@ -0,0 +1,32 @@
+#ifndef _INSTANCE_H_
+#define _INSTANCE_H_
+
+// Emulator instances. An instance is a complete copy of the emulation state of
+// the loaded game: everything the savestate format covers (cpu, ram, ppu, apu,
+// input ports and every mapper's registered state) plus the frame counter.
+// The core keeps its state in globals, so exactly one instance is live at a
+// time; selecting another one stores the live state in its slot and loads the
+// selected one. All instances share the ROM, the mapper code and the driver
+// settings, and are dropped when the game is closed.
+//
+// Instance 0 is the state the game was loaded into. Switching is refused while
+// a movie is active, since loading a state would be checked against the movie.
+
+// Copies the live state into a new instance. Returns its handle, or -1.
+int FCEUI_CreateInstance(void);
+// Makes instance id live.
+bool FCEUI_SelectInstance(int id);
+// Frees instance id. The live instance can not be destroyed.
+void FCEUI_DestroyInstance(int id);
+int FCEUI_GetInstance(void);
+int FCEUI_GetInstanceCount(void);
+
+// Runs frames frames on every instance in turn, then makes the instance that
+// was live before live again. Only the machine runs (see FCEU_EmulateCoreFrame):
+// each instance keeps the input its ports hold, and there is no input polling,
+// movie, Lua, picture or sound.
+void FCEUI_EmulateInstances(int frames);
+
+void FCEU_CloseInstances(void);
+
+#endif
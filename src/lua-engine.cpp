@@ -23,10 +23,12 @@
 #include "cheat.h"
 #include "x6502.h"
 #include "ppu.h"
+#include "cart.h"
 #include "utils/xstring.h"
 #include "utils/memory.h"
 #include "utils/crc32.h"
 #include "fceulua.h"
+#include "instance.h"
 
 extern char FileBase[];
 
@@ -189,6 +191,9 @@ int luaRunning = FALSE;
 // True at the frame boundary, false otherwise.
 static int frameBoundary = FALSE;
 
+// True while emu.run() is running frames; the script isn't resumed and callbacks aren't called.
+static int runningFrames = FALSE;
+
 // The execution speed we're running at.
 static enum {SPEED_NORMAL, SPEED_NOTHROTTLE, SPEED_TURBO, SPEED_MAXIMUM} speedmode = SPEED_NORMAL;
 
@@ -219,6 +224,9 @@ static enum { GUI_USED_SINCE_LAST_DISPLAY, GUI_USED_SINCE_LAST_FRAME, GUI_CLEAR
 static uint8 *gui_data = NULL;
 static int gui_saw_current_palette = FALSE;
 
+// Bumped every frame (and on rom changes); memory views from older generations are stale.
+static uint32 memoryViewGeneration = 0;
+
 // Protects Lua calls from going nuts.
 // We set this to a big number like 1000 and decrement it
 // over time. The script gets knifed once this reaches zero.
@@ -451,6 +459,180 @@ static int emu_frameadvance(lua_State *L) {
 	// It's actually rather disappointing...
 }
 
+// table emu.run(int frames, [table inputs], [table options])
+//
+//  Runs the frames right here instead of yielding to the driver once per frame,
+//  so there is no input polling, screen update or throttling in between.
+//  inputs[i] holds the buttons for frame i: a number for joypad 1 (bit 0 = A up to
+//  bit 7 = right, in the order joypad.set names them) or a table of up to four such
+//  numbers. Frames without an entry take the driver's input as it was.
+//  options.render (default false) draws the frames, options.sound (default false)
+//  keeps the sound channels running, options.ranges = {{address, length}, ...}
+//  selects what is returned.
+//  Returns one entry per frame: the CRC32 of the 2K of RAM, or the bytes of the
+//  ranges joined into a string. Registered callbacks and memory hooks are not
+//  called for these frames.
+static int emu_run(lua_State *L) {
+	if (frameAdvanceWaiting || !frameBoundary || runningFrames)
+		return luaL_error(L, "can't call emu.run() from here");
+	if (!GameInfo)
+		return luaL_error(L, "emu.run() needs a game");
+
+	int frames = luaL_checkinteger(L, 1);
+	bool hasInputs = !lua_isnoneornil(L, 2);
+	if (hasInputs)
+		luaL_checktype(L, 2, LUA_TTABLE);
+	bool render = false, sound = false;
+	std::vector<std::pair<int, int> > ranges;
+	int rangeBytes = 0;
+	if (!lua_isnoneornil(L, 3))
+	{
+		luaL_checktype(L, 3, LUA_TTABLE);
+		lua_getfield(L, 3, "render");
+		render = lua_toboolean(L, -1) != 0;
+		lua_getfield(L, 3, "sound");
+		sound = lua_toboolean(L, -1) != 0;
+		lua_getfield(L, 3, "ranges");
+		if (!lua_isnil(L, -1))
+		{
+			luaL_checktype(L, -1, LUA_TTABLE);
+			int n = lua_objlen(L, -1);
+			for (int i = 1; i <= n; i++)
+			{
+				lua_rawgeti(L, -1, i);
+				if (!lua_istable(L, -1))
+					return luaL_error(L, "emu.run() ranges must be {address, length} pairs");
+				lua_rawgeti(L, -1, 1);
+				lua_rawgeti(L, -2, 2);
+				int address = luaL_checkinteger(L, -2);
+				int length = luaL_checkinteger(L, -1);
+				if (address < 0 || length < 0 || address + length > 0x10000)
+					return luaL_error(L, "emu.run() range out of bounds");
+				ranges.push_back(std::make_pair(address, length));
+				rangeBytes += length;
+				lua_pop(L, 3);
+			}
+		}
+		lua_pop(L, 3);
+	}
+
+	bool oldComputeOnly = computeOnly, oldComputeSound = computeSound;
+	if (!render)
+		FCEUI_SetComputeOnly(true, sound);
+	else
+		FCEUI_SetComputeOnly(false);
+	// the script asked for these frames, so run them even if the user paused
+	int oldPaused = EmulationPaused;
+	EmulationPaused = 0;
+	runningFrames = TRUE;
+
+	std::vector<char> buf(rangeBytes);
+	lua_createtable(L, frames > 0 ? frames : 0, 0);
+	for (int f = 1; f <= frames; f++)
+	{
+		if (hasInputs)
+		{
+			lua_rawgeti(L, 2, f);
+			if (lua_isnumber(L, -1))
+			{
+				// both masks set to the value force exactly those buttons, whatever the driver holds
+				luajoypads1[0] = luajoypads2[0] = lua_tointeger(L, -1);
+			}
+			else if (lua_istable(L, -1))
+			{
+				for (int i = 0; i < 4; i++)
+				{
+					lua_rawgeti(L, -1, i + 1);
+					if (lua_isnumber(L, -1))
+					{
+						luajoypads1[i] = luajoypads2[i] = lua_tointeger(L, -1);
+					}
+					lua_pop(L, 1);
+				}
+			}
+			lua_pop(L, 1);
+		}
+
+		uint8 *gfx;
+		int32 *soundbuf;
+		int32 soundsize;
+		FCEUI_Emulate(&gfx, &soundbuf, &soundsize, render ? 0 : sound ? 1 : 2);
+
+		if (ranges.empty())
+			lua_pushinteger(L, CalcCRC32(0, RAM, 0x800));
+		else
+		{
+			char *p = rangeBytes ? &buf[0] : 0;
+			for (size_t r = 0; r < ranges.size(); r++)
+				for (int i = 0; i < ranges[r].second; i++)
+					*p++ = GetMem(ranges[r].first + i);
+			lua_pushlstring(L, rangeBytes ? &buf[0] : "", rangeBytes);
+		}
+		lua_rawseti(L, -2, f);
+	}
+
+	// a pad the game didn't read on the last frame would otherwise keep its override
+	for (int i = 0; i < 4; i++)
+	{
+		luajoypads1[i] = 0xFF;
+		luajoypads2[i] = 0x00;
+	}
+
+	runningFrames = FALSE;
+	EmulationPaused = oldPaused;
+	FCEUI_SetComputeOnly(oldComputeOnly, oldComputeSound);
+	return 1;
+}
+
+// int emu.createinstance()
+//
+//  Copies the running game into a new emulator instance and returns its handle,
+//  or nil if that isn't possible (no game, or a movie is active).
+static int emu_createinstance(lua_State *L) {
+	int id = FCEUI_CreateInstance();
+	if (id < 0)
+		return 0;
+	lua_pushinteger(L, id);
+	return 1;
+}
+
+// bool emu.selectinstance(int id)
+//
+//  Stores the running game in its instance and continues with instance id.
+static int emu_selectinstance(lua_State *L) {
+	if (frameAdvanceWaiting || !frameBoundary || runningFrames)
+		return luaL_error(L, "can't call emu.selectinstance() from here");
+	lua_pushboolean(L, FCEUI_SelectInstance(luaL_checkinteger(L, 1)));
+	return 1;
+}
+
+// emu.destroyinstance(int id)
+static int emu_destroyinstance(lua_State *L) {
+	FCEUI_DestroyInstance(luaL_checkinteger(L, 1));
+	return 0;
+}
+
+// int emu.getinstance()
+static int emu_getinstance(lua_State *L) {
+	lua_pushinteger(L, FCEUI_GetInstance());
+	return 1;
+}
+
+// emu.runinstances(int frames)
+//
+//  Runs frames frames on every instance, the running one included, and returns to
+//  the running one. Only the machine is emulated: every instance keeps the input
+//  its ports hold, nothing is drawn or heard, and callbacks aren't called.
+static int emu_runinstances(lua_State *L) {
+	if (frameAdvanceWaiting || !frameBoundary || runningFrames)
+		return luaL_error(L, "can't call emu.runinstances() from here");
+	int frames = luaL_checkinteger(L, 1);
+	runningFrames = TRUE;
+	FCEUI_EmulateInstances(frames);
+	runningFrames = FALSE;
+	return 0;
+}
+
 // bool emu.paused()
 static int emu_paused(lua_State *L)
 {
@@ -518,6 +700,8 @@ extern void ReloadRom(void);
 //  If the rom can't e loaded, loads the most recent one.
 static int emu_loadrom(lua_State *L) {
 #ifdef WIN32
+	memoryViewGeneration++;
+
 	const char* str = lua_tostring(L,1);
 
 	//special case: reload rom
@@ -1458,6 +1642,319 @@ static int ppu_readbyterange(lua_State *L) {
 	return 1;
 }
 
+// memory.writebyterange(int address, string bytes)
+//
+// Writes a whole string of bytes in one call, like repeated memory.writebyte().
+// Internal RAM is written with a single copy.
+static int memory_writebyterange(lua_State *L) {
+	size_t len;
+	int address = luaL_checkinteger(L,1);
+	const uint8 *bytes = (const uint8*)luaL_checklstring(L,2,&len);
+
+	if(address < 0 || address + len > 0x10000)
+		luaL_error(L,"range is out of bounds");
+
+	if(RAM && address + len <= 0x800)
+		memcpy(RAM + address, bytes, len);
+	else
+		for(size_t i = 0; i < len; i++)
+			FCEU_CheatSetByte(address + i, bytes[i]);
+
+	return 0;
+}
+
+// int memory.comparebyterange(int address, string bytes)
+//
+// Returns the address of the first byte that differs from the string, or nil when all match.
+static int memory_comparebyterange(lua_State *L) {
+	size_t len;
+	int address = luaL_checkinteger(L,1);
+	const uint8 *bytes = (const uint8*)luaL_checklstring(L,2,&len);
+
+	if(address < 0 || address + len > 0x10000)
+		luaL_error(L,"range is out of bounds");
+
+	for(size_t i = 0; i < len; i++) {
+		if(GetMem(address + i) != bytes[i]) {
+			lua_pushinteger(L, address + i);
+			return 1;
+		}
+	}
+
+	lua_pushnil(L);
+	return 1;
+}
+
+// Read-only window over one of the emulator's live memory buffers.
+// It points straight at the buffer, so it is only valid until the next frame.
+struct LuaMemoryView {
+	const uint8 *data;
+	uint32 size;
+	uint32 generation;
+};
+
+static const char *memoryViewMetatable = "FCEU.MemoryView";
+
+static LuaMemoryView *memoryview_check(lua_State *L, int idx) {
+	LuaMemoryView *view = (LuaMemoryView*)luaL_checkudata(L, idx, memoryViewMetatable);
+	if(view->generation != memoryViewGeneration)
+		luaL_error(L, "memory view is stale (views are only valid for the frame they were created in)");
+	return view;
+}
+
+// checks an optional (offset, size) pair against the view, defaulting to the whole view
+static void memoryview_checkrange(lua_State *L, LuaMemoryView *view, int idx, uint32 *offset, uint32 *size) {
+	// compared without adding, so huge values from the script can't wrap past the check
+	lua_Integer o = luaL_optinteger(L, idx, 0);
+	if(o < 0 || o > (lua_Integer)view->size)
+		luaL_error(L, "range is out of bounds");
+	lua_Integer s = luaL_optinteger(L, idx+1, view->size - o);
+	if(s < 0 || s > (lua_Integer)view->size - o)
+		luaL_error(L, "range is out of bounds");
+	*offset = (uint32)o;
+	*size = (uint32)s;
+}
+
+// string view:read([int offset [, int size]])
+static int memoryview_read(lua_State *L) {
+	LuaMemoryView *view = memoryview_check(L, 1);
+	uint32 offset, size;
+	memoryview_checkrange(L, view, 2, &offset, &size);
+	lua_pushlstring(L, (const char*)view->data + offset, size);
+	return 1;
+}
+
+// int view:compare(string bytes [, int offset])
+//
+// Returns the view offset of the first byte that differs from the string, or nil when all match.
+static int memoryview_compare(lua_State *L) {
+	LuaMemoryView *view = memoryview_check(L, 1);
+	size_t len;
+	const uint8 *bytes = (const uint8*)luaL_checklstring(L, 2, &len);
+	lua_Integer offset = luaL_optinteger(L, 3, 0);
+	if(offset < 0 || offset > (lua_Integer)view->size || len > view->size - (size_t)offset)
+		luaL_error(L, "range is out of bounds");
+
+	const uint8 *data = view->data + offset;
+	if(memcmp(data, bytes, len)) {
+		for(size_t i = 0; i < len; i++) {
+			if(data[i] != bytes[i]) {
+				lua_pushinteger(L, offset + i);
+				return 1;
+			}
+		}
+	}
+
+	lua_pushnil(L);
+	return 1;
+}
+
+// bool view:valid()
+static int memoryview_valid(lua_State *L) {
+	LuaMemoryView *view = (LuaMemoryView*)luaL_checkudata(L, 1, memoryViewMetatable);
+	lua_pushboolean(L, view->generation == memoryViewGeneration);
+	return 1;
+}
+
+// view[offset] reads a byte (offsets start at 0); names look up the methods above
+static int memoryview_index(lua_State *L) {
+	if(lua_type(L, 2) == LUA_TNUMBER) {
+		LuaMemoryView *view = memoryview_check(L, 1);
+		int offset = lua_tointeger(L, 2);
+		if(offset < 0 || (uint32)offset >= view->size)
+			lua_pushnil(L);
+		else
+			lua_pushinteger(L, view->data[offset]);
+		return 1;
+	}
+
+	lua_getmetatable(L, 1);
+	lua_getfield(L, -1, "methods");
+	lua_pushvalue(L, 2);
+	lua_rawget(L, -2);
+	return 1;
+}
+
+static int memoryview_newindex(lua_State *L) {
+	return luaL_error(L, "memory views are read-only, use memory.writebyterange()");
+}
+
+static int memoryview_len(lua_State *L) {
+	LuaMemoryView *view = (LuaMemoryView*)luaL_checkudata(L, 1, memoryViewMetatable);
+	lua_pushinteger(L, view->size);
+	return 1;
+}
+
+static const struct luaL_reg memoryviewmethods [] = {
+	{"read", memoryview_read},
+	{"compare", memoryview_compare},
+	{"valid", memoryview_valid},
+	{NULL,NULL}
+};
+
+// view memory.view(string region [, int index])
+//
+// Returns a read-only view over a live memory buffer. Regions are
+// "ram" (2KB), "sram" (8KB at $6000, when mapped as one bank), "oam" (256 bytes),
+// "palette" (32 bytes) and "nametable" (1KB, index 0-3 selects $2000/$2400/$2800/$2C00).
+static int memory_view(lua_State *L) {
+	const char *region = luaL_checkstring(L, 1);
+	const uint8 *data = NULL;
+	uint32 size = 0;
+
+	if(!GameInfo)
+		luaL_error(L, "no game is loaded");
+
+	if(!stricmp(region, "ram")) {
+		data = RAM;
+		size = 0x800;
+	} else if(!stricmp(region, "sram")) {
+		// Page[] holds bank base minus address, so one 8KB bank has four equal entries
+		uint8 *page = Page[0x6000 >> 11];
+		if(GameInfo->type != GIT_CART || Page[0x6800 >> 11] != page || Page[0x7000 >> 11] != page || Page[0x7800 >> 11] != page)
+			luaL_error(L, "sram is not mapped as a single bank");
+		data = page + 0x6000;
+		size = 0x2000;
+	} else if(!stricmp(region, "oam")) {
+		data = SPRAM;
+		size = 0x100;
+	} else if(!stricmp(region, "palette")) {
+		data = PALRAM;
+		size = 0x20;
+	} else if(!stricmp(region, "nametable")) {
+		int index = luaL_optinteger(L, 2, 0);
+		if(index < 0 || index > 3)
+			luaL_error(L, "nametable index must be 0-3");
+		data = vnapage[index];
+		size = 0x400;
+	} else
+		luaL_error(L, "unknown memory region %s", region);
+
+	if(!data)
+		luaL_error(L, "%s is not available", region);
+
+	LuaMemoryView *view = (LuaMemoryView*)lua_newuserdata(L, sizeof(LuaMemoryView));
+	view->data = data;
+	view->size = size;
+	view->generation = memoryViewGeneration;
+
+	if(luaL_newmetatable(L, memoryViewMetatable)) {
+		lua_pushcfunction(L, memoryview_index);
+		lua_setfield(L, -2, "__index");
+		lua_pushcfunction(L, memoryview_newindex);
+		lua_setfield(L, -2, "__newindex");
+		lua_pushcfunction(L, memoryview_len);
+		lua_setfield(L, -2, "__len");
+		lua_newtable(L);
+		luaL_register(L, NULL, memoryviewmethods);
+		lua_setfield(L, -2, "methods");
+	}
+	lua_setmetatable(L, -2);
+
+	return 1;
+}
+
+// int ramsearch.reset([int size = 1[, bool signed = false]])
+//
+//  Starts a new search over RAM and cartridge WRAM for values of the given byte size,
+//  taking the current memory as the previous values. Returns the number of candidates.
+static int ramsearch_reset(lua_State *L)
+{
+	int size = luaL_optinteger(L, 1, 1);
+	bool sign = lua_toboolean(L, 2) != 0;
+
+	int32 count = FCEUI_RamSearchReset(size, sign);
+	if (count < 0)
+		luaL_error(L, "ramsearch.reset: size must be 1, 2 or 4");
+	lua_pushinteger(L, count);
+	return 1;
+}
+
+static const struct { const char *name; int op; } ramsearchops[] = {
+	{"<", FCEU_RS_LESS},
+	{">", FCEU_RS_GREATER},
+	{"<=", FCEU_RS_LESSEQUAL},
+	{">=", FCEU_RS_GREATEREQUAL},
+	{"==", FCEU_RS_EQUAL},
+	{"~=", FCEU_RS_NOTEQUAL},
+	{"!=", FCEU_RS_NOTEQUAL},
+	{"diff", FCEU_RS_DIFFERENTBY},
+};
+
+// int ramsearch.filter(string op[, int value])
+//
+//  Keeps the candidates for which "current op previous" holds, or "current op value"
+//  when a value is given. op "diff" keeps those that changed by exactly value.
+//  Returns the number of candidates left.
+static int ramsearch_filter(lua_State *L)
+{
+	const char *name = luaL_checkstring(L, 1);
+	int op = -1;
+	for (size_t i = 0; i < sizeof(ramsearchops) / sizeof(ramsearchops[0]); i++)
+		if (!strcmp(name, ramsearchops[i].name))
+			op = ramsearchops[i].op;
+	if (op < 0)
+		luaL_error(L, "ramsearch.filter: unknown comparison \"%s\"", name);
+
+	bool specific = !lua_isnoneornil(L, 2);
+	if (op == FCEU_RS_DIFFERENTBY && !specific)
+		luaL_error(L, "ramsearch.filter: \"diff\" needs a value");
+
+	int32 value = (int32)(int64)luaL_optnumber(L, 2, 0);
+	lua_pushinteger(L, FCEUI_RamSearchFilter(op, specific, value));
+	return 1;
+}
+
+// int ramsearch.count()
+static int ramsearch_count(lua_State *L)
+{
+	lua_pushinteger(L, FCEUI_RamSearchGetCount());
+	return 1;
+}
+
+struct RamSearchResults
+{
+	lua_State *L;
+	int count;
+	int limit;
+};
+
+static int ramsearch_resultscallb(uint32 a, int64 last, int64 current, void *data)
+{
+	RamSearchResults *res = (RamSearchResults *)data;
+	lua_State *L = res->L;
+
+	lua_createtable(L, 0, 3);
+	lua_pushinteger(L, a);
+	lua_setfield(L, -2, "address");
+	lua_pushnumber(L, (lua_Number)last);
+	lua_setfield(L, -2, "previous");
+	lua_pushnumber(L, (lua_Number)current);
+	lua_setfield(L, -2, "current");
+	lua_rawseti(L, -2, ++res->count);
+
+	return res->limit <= 0 || res->count < res->limit;
+}
+
+// table ramsearch.results([int limit])
+//
+//  Returns an array of {address, previous, current} for the remaining candidates.
+static int ramsearch_results(lua_State *L)
+{
+	RamSearchResults res = { L, 0, (int)luaL_optinteger(L, 1, 0) };
+
+	lua_newtable(L);
+	FCEUI_RamSearchGet(ramsearch_resultscallb, &res);
+	return 1;
+}
+
+// ramsearch.exclude(int address)
+static int ramsearch_exclude(lua_State *L)
+{
+	FCEUI_RamSearchExclude(luaL_checkinteger(L, 1));
+	return 0;
+}
+
 static inline bool isalphaorunderscore(char c)
 {
 	return isalpha(c) || c == '_';
@@ -1940,193 +2437,105 @@ void HandleCallbackError(lua_State* L)
 }
 
 
-// the purpose of this structure is to provide a way of
-// QUICKLY determining whether a memory address range has a hook associated with it,
-// with a bias toward fast rejection because the majority of addresses will not be hooked.
-// (it must not use any part of Lua or perform any per-script operations,
-//  otherwise it would definitely be too slow.)
-// calculating the regions when a hook is added/removed may be slow,
+// one bit per cpu address for each hook type, so the cpu can tell with a single test
+// whether an access is hooked (most are not). null while a hook type has no hooks.
+unsigned int *luaMemHookBits [LUAMEMHOOK_COUNT];
+static std::vector<unsigned int> hookBitmaps [LUAMEMHOOK_COUNT];
+// registry ref of the callback for every hooked address, one ref per distinct function
+static std::vector<int> hookRefs [LUAMEMHOOK_COUNT];
+static std::vector<int> hookFuncRefs [LUAMEMHOOK_COUNT];
+
+// rebuilding the bitmap and refs when a hook is added/removed may be slow,
 // but this is an intentional tradeoff to obtain a high speed of checking during later execution
-struct TieredRegion
+static void CalculateMemHookRegions(LuaMemHookType hookType)
 {
-	template<unsigned int maxGap>
-	struct Region
-	{
-		struct Island
-		{
-			unsigned int start;
-			unsigned int end;
-#ifdef NEED_MINGW_HACKS
-			bool Contains(unsigned int address, int size) const { return address < end && address+size > start; }
-#else
-			__forceinline bool Contains(unsigned int address, int size) const { return address < end && address+size > start; }
-#endif
-		};
-		std::vector<Island> islands;
+	std::vector<unsigned int>& bits = hookBitmaps[hookType];
+	std::vector<int>& refs = hookRefs[hookType];
+	std::vector<int>& funcs = hookFuncRefs[hookType];
 
-		void Calculate(const std::vector<unsigned int>& bytes)
-		{
-			islands.clear();
+	if(L)
+	{
+		for(size_t i = 0; i != funcs.size(); ++i)
+			luaL_unref(L, LUA_REGISTRYINDEX, funcs[i]);
+	}
+	funcs.clear();
+	bits.clear();
+	refs.clear();
+	luaMemHookBits[hookType] = NULL;
 
-			unsigned int lastEnd = ~0;
+	if(!numMemHooks || !L)
+		return;
 
-			std::vector<unsigned int>::const_iterator iter = bytes.begin();
-			std::vector<unsigned int>::const_iterator end = bytes.end();
-			for(; iter != end; ++iter)
+	std::map<const void*, int> funcToRef;
+	lua_settop(L, 0);
+	lua_getfield(L, LUA_REGISTRYINDEX, luaMemHookTypeStrings[hookType]);
+	lua_pushnil(L);
+	while(lua_next(L, -2))
+	{
+		unsigned int addr = lua_tointeger(L, -2);
+		// the cpu never accesses anything past $FFFF
+		if(lua_isfunction(L, -1) && addr < 0x10000)
+		{
+			if(bits.empty())
 			{
-				unsigned int addr = *iter;
-				if(addr < lastEnd || addr > lastEnd + (long long)maxGap)
-				{
-					islands.push_back(Island());
-					islands.back().start = addr;
-				}
-				islands.back().end = addr+1;
-				lastEnd = addr+1;
+				bits.assign(0x10000 / 32, 0);
+				refs.assign(0x10000, LUA_NOREF);
 			}
-		}
-		bool Contains(unsigned int address, int size) const
-		{
-			for (size_t i = 0; i != islands.size(); ++i)
+			std::map<const void*, int>::iterator iter = funcToRef.find(lua_topointer(L, -1));
+			int ref;
+			if(iter != funcToRef.end())
+				ref = iter->second;
+			else
 			{
-				if (islands[i].Contains(address, size))
-					return true;
+				const void* func = lua_topointer(L, -1);
+				lua_pushvalue(L, -1);
+				ref = luaL_ref(L, LUA_REGISTRYINDEX);
+				funcToRef[func] = ref;
+				funcs.push_back(ref);
 			}
-			return false;
+			bits[addr >> 5] |= 1u << (addr & 31);
+			refs[addr] = ref;
 		}
-	};
-
-	Region<0xFFFFFFFF> broad;
-	Region<0x1000> mid;
-	Region<0> narrow;
-
-	void Calculate(std::vector<unsigned int>& bytes)
-	{
-		std::sort(bytes.begin(), bytes.end());
-
-		broad.Calculate(bytes);
-		mid.Calculate(bytes);
-		narrow.Calculate(bytes);
+		lua_pop(L, 1);
 	}
+	lua_settop(L, 0);
 
-	TieredRegion()
-	{
-		std::vector <unsigned int> temp;
-		Calculate(temp);
-	}
+	if(!bits.empty())
+		luaMemHookBits[hookType] = &bits[0];
+}
 
-	__forceinline int NotEmpty()
-	{
-		return broad.islands.size();
-	}
+// called by CallRegisteredLuaMemHook (fceulua.h) once the bitmap says the access may be hooked
+void CallRegisteredLuaMemHook_Dispatch(unsigned int address, int size, unsigned int value, LuaMemHookType hookType)
+{
+	if(!L || !numMemHooks || runningFrames)
+		return;
 
-	// note: it is illegal to call this if NotEmpty() returns 0
-	__forceinline bool Contains(unsigned int address, int size)
+	const std::vector<int>& refs = hookRefs[hookType];
+	for(unsigned int i = address; i != address+size && i < 0x10000; i++)
 	{
-		return broad.islands[0].Contains(address,size) &&
-		       mid.Contains(address,size) &&
-			   narrow.Contains(address,size);
-	}
-};
-TieredRegion hookedRegions [LUAMEMHOOK_COUNT];
-
-
-static void CalculateMemHookRegions(LuaMemHookType hookType)
-{
-	std::vector<unsigned int> hookedBytes;
-//	std::map<int, LuaContextInfo*>::iterator iter = luaContextInfo.begin();
-//	std::map<int, LuaContextInfo*>::iterator end = luaContextInfo.end();
-//	while(iter != end)
-//	{
-//		LuaContextInfo& info = *iter->second;
-		if(/*info.*/ numMemHooks)
-		{
-//			lua_State* L = info.L;
-			if(L)
-			{
-				lua_settop(L, 0);
-				lua_getfield(L, LUA_REGISTRYINDEX, luaMemHookTypeStrings[hookType]);
-				lua_pushnil(L);
-				while(lua_next(L, -2))
-				{
-					if(lua_isfunction(L, -1))
-					{
-						unsigned int addr = lua_tointeger(L, -2);
-						hookedBytes.push_back(addr);
-					}
-					lua_pop(L, 1);
-				}
-				lua_settop(L, 0);
-			}
-		}
-//		++iter;
-//	}
-	hookedRegions[hookType].Calculate(hookedBytes);
-}
+		if(refs[i] == LUA_NOREF)
+			continue;
 
-static void CallRegisteredLuaMemHook_LuaMatch(unsigned int address, int size, unsigned int value, LuaMemHookType hookType)
-{
-//	std::map<int, LuaContextInfo*>::iterator iter = luaContextInfo.begin();
-//	std::map<int, LuaContextInfo*>::iterator end = luaContextInfo.end();
-//	while(iter != end)
-//	{
-//		LuaContextInfo& info = *iter->second;
-		if(/*info.*/ numMemHooks)
+		lua_settop(L, 0);
+		lua_rawgeti(L, LUA_REGISTRYINDEX, refs[i]);
+		bool wasRunning = (luaRunning!=0) /*info.running*/;
+		luaRunning /*info.running*/ = true;
+		//RefreshScriptSpeedStatus();
+		lua_pushinteger(L, address);
+		lua_pushinteger(L, size);
+		lua_pushinteger(L, value);
+		int errorcode = lua_pcall(L, 3, 0, 0);
+		luaRunning /*info.running*/ = wasRunning;
+		//RefreshScriptSpeedStatus();
+		if (errorcode)
 		{
-//			lua_State* L = info.L;
-			if(L/* && !info.panic*/)
-			{
-#ifdef USE_INFO_STACK
-				infoStack.insert(infoStack.begin(), &info);
-				struct Scope { ~Scope(){ infoStack.erase(infoStack.begin()); } } scope;
-#endif
-				lua_settop(L, 0);
-				lua_getfield(L, LUA_REGISTRYINDEX, luaMemHookTypeStrings[hookType]);
-				for(int i = address; i != address+size; i++)
-				{
-					lua_rawgeti(L, -1, i);
-					if (lua_isfunction(L, -1))
-					{
-						bool wasRunning = (luaRunning!=0) /*info.running*/;
-						luaRunning /*info.running*/ = true;
-						//RefreshScriptSpeedStatus();
-						lua_pushinteger(L, address);
-						lua_pushinteger(L, size);
-						lua_pushinteger(L, value);
-						int errorcode = lua_pcall(L, 3, 0, 0);
-						luaRunning /*info.running*/ = wasRunning;
-						//RefreshScriptSpeedStatus();
-						if (errorcode)
-						{
-							HandleCallbackError(L);
-							//int uid = iter->first;
-							//HandleCallbackError(L,info,uid,true);
-						}
-						break;
-					}
-					else
-					{
-						lua_pop(L,1);
-					}
-				}
-				lua_settop(L, 0);
-			}
+			HandleCallbackError(L);
+			//int uid = iter->first;
+			//HandleCallbackError(L,info,uid,true);
 		}
-//		++iter;
-//	}
-}
-void CallRegisteredLuaMemHook(unsigned int address, int size, unsigned int value, LuaMemHookType hookType)
-{
-	// performance critical! (called VERY frequently)
-	// I suggest timing a large number of calls to this function in Release if you change anything in here,
-	// before and after, because even the most innocent change can make it become 30% to 400% slower.
-	// a good amount to test is: 100000000 calls with no hook set, and another 100000000 with a hook set.
-	// (on my system that consistently took 200 ms total in the former case and 350 ms total in the latter case)
-	if(hookedRegions[hookType].NotEmpty())
-	{
-		//if((hookType <= LUAMEMHOOK_EXEC) && (address >= 0xE00000))
-		//	address |= 0xFF0000; // account for mirroring of RAM
-		if(hookedRegions[hookType].Contains(address, size))
-			CallRegisteredLuaMemHook_LuaMatch(address, size, value, hookType); // something has hooked this specific address
+		if(L)
+			lua_settop(L, 0);
+		break;
 	}
 }
 
@@ -2135,7 +2544,7 @@ void CallRegisteredLuaFunctions(LuaCallID calltype)
 	assert((unsigned int)calltype < (unsigned int)LUACALL_COUNT);
 	const char* idstring = luaCallIDStrings[calltype];
 
-	if (!L)
+	if (!L || runningFrames)
 		return;
 
 	lua_settop(L, 0);
@@ -2503,9 +2912,11 @@ static int zapper_read(lua_State *L){
 		else
 			z = currFrameCounter -1;
 
-		x = currMovieData.records[z].zappers[1].x;	//adelikat:  Used hardcoded port 1 since as far as I know, only port 1 is valid for zappers
-		y = currMovieData.records[z].zappers[1].y;
-		click = currMovieData.records[z].zappers[1].b;
+		MovieRecord mr;
+		currMovieData.records.get(z, mr);
+		x = mr.zappers[1].x;	//adelikat:  Used hardcoded port 1 since as far as I know, only port 1 is valid for zappers
+		y = mr.zappers[1].y;
+		click = mr.zappers[1].b;
 	}
 	else
 	{
@@ -3205,12 +3616,53 @@ static int movie_isfromsavestate (lua_State *L) {
 #define LUA_SCREEN_WIDTH    256
 #define LUA_SCREEN_HEIGHT   240
 
+// Horizontal extent of the pixels drawn on each row of gui_data since it was
+// last cleared, plus the range of rows that have any. Compositing and clearing
+// only visit these spans, so a small HUD costs a few rows instead of the whole canvas.
+static int gui_dirty_left[LUA_SCREEN_HEIGHT];
+static int gui_dirty_right[LUA_SCREEN_HEIGHT];
+static int gui_dirty_top = LUA_SCREEN_HEIGHT;
+static int gui_dirty_bottom = -1;
+
+// When set, FCEU_LuaGui leaves XBuf alone and the driver blends gui_data
+// in RGB after its palette expansion (see FCEU_LuaGuiGetOverlay).
+static bool gui_rgb_overlay = false;
+
+static inline void gui_mark_dirty(int x1, int x2, int y) {
+	if (x1 < gui_dirty_left[y])
+		gui_dirty_left[y] = x1;
+	if (x2 > gui_dirty_right[y])
+		gui_dirty_right[y] = x2;
+	if (y < gui_dirty_top)
+		gui_dirty_top = y;
+	if (y > gui_dirty_bottom)
+		gui_dirty_bottom = y;
+}
+
+// clear the touched parts of gui_data and forget them
+static void gui_clear() {
+	for (int y = gui_dirty_top; y <= gui_dirty_bottom; y++) {
+		if (gui_dirty_left[y] <= gui_dirty_right[y])
+			memset(&gui_data[(y*LUA_SCREEN_WIDTH+gui_dirty_left[y])*4], 0, (gui_dirty_right[y]-gui_dirty_left[y]+1)*4);
+		gui_dirty_left[y] = LUA_SCREEN_WIDTH;
+		gui_dirty_right[y] = -1;
+	}
+	gui_dirty_top = LUA_SCREEN_HEIGHT;
+	gui_dirty_bottom = -1;
+}
+
 // Common code by the gui library: make sure the screen array is ready
 static void gui_prepare() {
-	if (!gui_data)
+	if (!gui_data) {
 		gui_data = (uint8*) FCEU_dmalloc(LUA_SCREEN_WIDTH*LUA_SCREEN_HEIGHT*4);
-	if (gui_used != GUI_USED_SINCE_LAST_DISPLAY)
 		memset(gui_data, 0, LUA_SCREEN_WIDTH*LUA_SCREEN_HEIGHT*4);
+		for (int y = 0; y < LUA_SCREEN_HEIGHT; y++) {
+			gui_dirty_left[y] = LUA_SCREEN_WIDTH;
+			gui_dirty_right[y] = -1;
+		}
+	}
+	if (gui_used != GUI_USED_SINCE_LAST_DISPLAY)
+		gui_clear();
 	gui_used = GUI_USED_SINCE_LAST_DISPLAY;
 }
 
@@ -3264,6 +3716,7 @@ static inline bool gui_check_boundary(int x, int y) {
 static inline void gui_drawpixel_fast(int x, int y, uint32 colour) {
 	//gui_prepare();
 	blend32((uint32*) &gui_data[(y*LUA_SCREEN_WIDTH+x)*4], colour);
+	gui_mark_dirty(x, x, y);
 }
 
 // write a pixel to gui_data (check boundaries)
@@ -3365,13 +3818,17 @@ static void gui_fillbox_internal(int x1, int y1, int x2, int y2, uint32 colour)
 		y2 = LUA_SCREEN_HEIGHT - 1;
 
 	//gui_prepare();
+	if (x1 > x2)
+		return;
 	int ix, iy;
 	for (iy = y1; iy <= y2; iy++)
 	{
+		uint32 *dst = (uint32*) &gui_data[(iy*LUA_SCREEN_WIDTH+x1)*4];
 		for (ix = x1; ix <= x2; ix++)
 		{
-			gui_drawpixel_fast(ix, iy, colour);
+			blend32(dst++, colour);
 		}
+		gui_mark_dirty(x1, x2, iy);
 	}
 }
 
@@ -3415,6 +3872,21 @@ enum
 	, GUI_COLOUR_RED,   GUI_COLOUR_GREEN, GUI_COLOUR_BLUE
 	*/
 };
+// The driver palette as seen by the compositor, refreshed lazily after
+// FCEU_LuaUpdatePalette() so blending doesn't call into the driver per pixel.
+static uint8 gui_palette_rgb[256][3];
+static uint8 gui_index_lookup[1 << (3+3+3)];
+
+static void gui_check_palette() {
+	if (gui_saw_current_palette)
+		return;
+
+	for (int i = 0; i < 256; i++)
+		FCEUD_GetPalette(i, &gui_palette_rgb[i][0], &gui_palette_rgb[i][1], &gui_palette_rgb[i][2]);
+	memset(gui_index_lookup, GUI_COLOUR_CLEAR, sizeof(gui_index_lookup));
+	gui_saw_current_palette = TRUE;
+}
+
 /**
  * Returns an index approximating an RGB colour.
  * TODO: This is easily improvable in terms of speed and probably
@@ -3423,30 +3895,24 @@ enum
  * ourselves.
  */
 static uint8 gui_colour_rgb(uint8 r, uint8 g, uint8 b) {
-	static uint8 index_lookup[1 << (3+3+3)];
 	int k;
 
-	if (!gui_saw_current_palette)
-	{
-		memset(index_lookup, GUI_COLOUR_CLEAR, sizeof(index_lookup));
-		gui_saw_current_palette = TRUE;
-	}
+	gui_check_palette();
 
 	k = ((r & 0xE0) << 1) | ((g & 0xE0) >> 2) | ((b & 0xE0) >> 5);
 	uint16 test, best = GUI_COLOUR_CLEAR;
 	uint32 best_score = 0xffffffffu, test_score;
-	if (index_lookup[k] != GUI_COLOUR_CLEAR) return index_lookup[k];
+	if (gui_index_lookup[k] != GUI_COLOUR_CLEAR) return gui_index_lookup[k];
 	for (test = 0; test < 0xff; test++)
 	{
-		uint8 tr, tg, tb;
 		if (test == GUI_COLOUR_CLEAR) continue;
-		FCEUD_GetPalette(test, &tr, &tg, &tb);
-		test_score = abs(r - tr) *  66 +
-		             abs(g - tg) * 129 +
-		             abs(b - tb) *  25;
+		const uint8 *trgb = gui_palette_rgb[test];
+		test_score = abs(r - trgb[0]) *  66 +
+		             abs(g - trgb[1]) * 129 +
+		             abs(b - trgb[2]) *  25;
 		if (test_score < best_score) best_score = test_score, best = test;
 	}
-	index_lookup[k] = best;
+	gui_index_lookup[k] = best;
 	return best;
 }
 
@@ -3455,6 +3921,35 @@ void FCEU_LuaUpdatePalette()
 	gui_saw_current_palette = FALSE;
 }
 
+/**
+ * Selects where the GUI is composited. When enabled the 8-bit screen is left
+ * untouched and the driver blends the overlay itself after palette expansion,
+ * avoiding the nearest-colour search. Drivers should only enable this when they
+ * blit unfiltered, since the overlay rows/columns map 1:1 onto XBuf.
+ */
+void FCEU_LuaGuiSetRGBOverlay(bool enabled)
+{
+	gui_rgb_overlay = enabled;
+}
+
+/**
+ * Returns the 256x240 GUI canvas (B,G,R,A bytes per pixel) for the driver to
+ * blend in RGB mode, or NULL if there is nothing to draw. The first and last
+ * touched rows and the per-row touched column ranges are returned so callers
+ * can skip clean areas; a row with left > right is empty.
+ */
+const uint8 *FCEU_LuaGuiGetOverlay(int *firstLine, int *lastLine, const int **spanLeft, const int **spanRight)
+{
+	if (!gui_rgb_overlay || !gui_data || gui_used == GUI_CLEAR || gui_dirty_top > gui_dirty_bottom)
+		return NULL;
+
+	*firstLine = gui_dirty_top;
+	*lastLine = gui_dirty_bottom;
+	*spanLeft = gui_dirty_left;
+	*spanRight = gui_dirty_right;
+	return gui_data;
+}
+
 // Helper for a simple hex parser
 static int hex2int(lua_State *L, char c) {
 	if (c >= '0' && c <= '9')
@@ -5716,6 +6211,12 @@ static const struct luaL_reg emulib [] = {
 	{"softreset", emu_softreset},
 	{"speedmode", emu_speedmode},
 	{"frameadvance", emu_frameadvance},
+	{"run", emu_run},
+	{"createinstance", emu_createinstance},
+	{"selectinstance", emu_selectinstance},
+	{"destroyinstance", emu_destroyinstance},
+	{"getinstance", emu_getinstance},
+	{"runinstances", emu_runinstances},
 	{"paused", emu_paused},
 	{"pause", emu_pause},
 	{"unpause", emu_unpause},
@@ -5765,6 +6266,9 @@ static const struct luaL_reg memorylib [] = {
 	{"readwordsigned", memory_readwordsigned},
 	{"readwordunsigned", memory_readword},	// alternate naming scheme for unsigned
 	{"writebyte", memory_writebyte},
+	{"writebyterange", memory_writebyterange},
+	{"comparebyterange", memory_comparebyterange},
+	{"view", memory_view},
 	{"getregister", memory_getregister},
 	{"setregister", memory_setregister},
 
@@ -5900,6 +6404,16 @@ static const struct luaL_reg guilib[] = {
 	{NULL,NULL}
 };
 
+static const struct luaL_reg ramsearchlib[] = {
+
+	{"reset", ramsearch_reset},
+	{"filter", ramsearch_filter},
+	{"count", ramsearch_count},
+	{"results", ramsearch_results},
+	{"exclude", ramsearch_exclude},
+	{NULL,NULL}
+};
+
 static const struct luaL_reg soundlib[] = {
 
 	{"get", sound_get},
@@ -5983,8 +6497,11 @@ void FCEU_LuaFrameBoundary()
 {
 	//printf("Lua Frame\n");
 
+	// memory views only live for one frame
+	memoryViewGeneration++;
+
 	// HA!
-	if (!L || !luaRunning)
+	if (!L || !luaRunning || runningFrames)
 		return;
 
 	// Our function needs calling
@@ -6094,6 +6611,7 @@ int FCEU_LoadLuaCode(const char *filename, const char *arg) {
 		luaL_register(L, "emu", emulib); // added for better cross-emulator compatibility
 		luaL_register(L, "FCEU", emulib); // kept for backward compatibility
 		luaL_register(L, "memory", memorylib);
+		luaL_register(L, "ramsearch", ramsearchlib);
 		luaL_register(L, "ppu", ppulib);
 		luaL_register(L, "rom", romlib);
 		luaL_register(L, "joypad", joypadlib);
@@ -6381,29 +6899,38 @@ void FCEU_LuaGui(uint8 *XBuf)
 
 	if (gui_used == GUI_USED_SINCE_LAST_FRAME && !FCEUI_EmulationPaused())
 	{
-		memset(gui_data, 0, LUA_SCREEN_WIDTH*LUA_SCREEN_HEIGHT*4);
+		gui_clear();
 		gui_used = GUI_CLEAR;
 		return;
 	}
 
 	gui_used = GUI_USED_SINCE_LAST_FRAME;
 
+	// the driver blends gui_data itself
+	if (gui_rgb_overlay)
+		return;
+
+	gui_check_palette();
+
 	int x, y;
 
-	for (y = 0; y < LUA_SCREEN_HEIGHT; y++)
+	for (y = gui_dirty_top; y <= gui_dirty_bottom; y++)
 	{
-		for (x=0; x < LUA_SCREEN_WIDTH; x++)
+		const uint8 *src = &gui_data[(y*LUA_SCREEN_WIDTH+gui_dirty_left[y])*4];
+		uint8 *dst = &XBuf[y*256+gui_dirty_left[y]];
+
+		for (x = gui_dirty_left[y]; x <= gui_dirty_right[y]; x++, src += 4, dst++)
 		{
-			const uint8 gui_alpha = gui_data[(y*LUA_SCREEN_WIDTH+x)*4+3];
+			const uint8 gui_alpha = src[3];
 			if (gui_alpha == 0)
 			{
 				// do nothing
 				continue;
 			}
 
-			const uint8 gui_red   = gui_data[(y*LUA_SCREEN_WIDTH+x)*4+2];
-			const uint8 gui_green = gui_data[(y*LUA_SCREEN_WIDTH+x)*4+1];
-			const uint8 gui_blue  = gui_data[(y*LUA_SCREEN_WIDTH+x)*4];
+			const uint8 gui_red   = src[2];
+			const uint8 gui_green = src[1];
+			const uint8 gui_blue  = src[0];
 
 			int r, g, b;
 			if (gui_alpha == 255) {
@@ -6414,14 +6941,13 @@ void FCEU_LuaGui(uint8 *XBuf)
 			}
 			else {
 				// alpha-blending
-				uint8 scr_red, scr_green, scr_blue;
-				FCEUD_GetPalette(XBuf[(y)*256+x], &scr_red, &scr_green, &scr_blue);
-				r = (((int) gui_red   - scr_red)   * gui_alpha / 255 + scr_red)   & 255;
-				g = (((int) gui_green - scr_green) * gui_alpha / 255 + scr_green) & 255;
-				b = (((int) gui_blue  - scr_blue)  * gui_alpha / 255 + scr_blue)  & 255;
+				const uint8 *scr = gui_palette_rgb[*dst];
+				r = (((int) gui_red   - scr[0]) * gui_alpha / 255 + scr[0]) & 255;
+				g = (((int) gui_green - scr[1]) * gui_alpha / 255 + scr[1]) & 255;
+				b = (((int) gui_blue  - scr[2]) * gui_alpha / 255 + scr[2]) & 255;
 			}
 
-			XBuf[(y)*256+x] = gui_colour_rgb(r, g, b);
+			*dst = gui_colour_rgb(r, g, b);
 		}
 	}
 
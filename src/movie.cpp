@@ -1,4 +1,5 @@
 #include "emufile.h"
+#include "emufile_async.h"
 #include "version.h"
 #include "types.h"
 #include "utils/endian.h"
@@ -39,6 +40,7 @@ extern int RAMInitOption;
 extern int RAMInitSeed;
 
 #include <cstdio>
+#include <algorithm>
 #include <cstdlib>
 #include <cstring>
 #include <cassert>
@@ -122,20 +124,7 @@ void MovieData::clearRecordRange(int start, int len)
 
 void MovieData::eraseRecords(int at, int frames)
 {
-	if (at < (int)records.size())
-	{
-		if (frames == 1)
-		{
-			// erase 1 frame
-			records.erase(records.begin() + at);
-		} else
-		{
-			// erase many frames
-			if (at + frames > (int)records.size())
-				frames = (int)records.size() - at;
-			records.erase(records.begin() + at, records.begin() + (at + frames));
-		}
-	}
+	records.erase(at, frames);
 }
 
 void MovieData::insertEmpty(int at, int frames)
@@ -145,7 +134,7 @@ void MovieData::insertEmpty(int at, int frames)
 		records.resize(records.size() + frames);
 	} else
 	{
-		records.insert(records.begin() + at, frames, MovieRecord());
+		records.insert(at, frames);
 	}
 }
 
@@ -153,10 +142,14 @@ void MovieData::cloneRegion(int at, int frames)
 {
 	if (at < 0) return;
 
-	records.insert(records.begin() + at, frames, MovieRecord());
+	records.insert(at, frames);
 
+	MovieRecord mr;
 	for(int i = 0; i < frames; i++)
-		records[i + at].Clone(records[i + at + frames]);
+	{
+		records.get(i + at + frames, mr);
+		records.set(i + at, mr);
+	}
 }
 // ----------------------------------------------------------------------------
 MovieRecord::MovieRecord()
@@ -238,7 +231,7 @@ void MovieRecord::dumpJoy(EMUFILE* os, uint8 joystate)
 
 void MovieRecord::parseJoy(EMUFILE* is, uint8& joystate)
 {
-	char buf[8];
+	char buf[8] = {0};
 	is->fread(buf,8);
 	joystate = 0;
 	for(int i=0;i<8;i++)
@@ -391,6 +384,456 @@ void MovieRecord::dump(MovieData* md, EMUFILE* os, int index)
 	os->fputc('\n');
 }
 
+// ----------------------------------------------------------------------------
+struct MovieRecordList::Chunk
+{
+	std::vector<uint8> joysticks; //4 per frame
+	std::vector<uint8> commands;
+	std::vector<MovieRecord::Zapper> zappers; //2 per frame, or empty if no frame in the chunk has zapper data
+
+	int size() const { return (int)commands.size(); }
+};
+
+static bool ZappersUsed(const MovieRecord& mr)
+{
+	static const MovieRecord::Zapper none[2] = {};
+	return memcmp(mr.zappers, none, sizeof(none)) != 0;
+}
+
+MovieRecord::Zapper& MovieRecordRef::ZapperRef::operator[](int w)
+{
+	if (column->empty())
+	{
+		MovieRecord::Zapper none = {};
+		column->resize(count * 2, none);
+	}
+	return (*column)[index * 2 + w];
+}
+
+void MovieRecordRef::ZapperRef::clear()
+{
+	if (!column->empty())
+		memset(&(*column)[index * 2], 0, sizeof(MovieRecord::Zapper) * 2);
+}
+
+void MovieRecordRef::clear()
+{
+	commands = 0;
+	memset(joysticks, 0, 4);
+	zappers.clear();
+}
+
+MovieRecordList::MovieRecordList()
+	: count(0)
+	, lastChunk(0)
+	, prefixValid(0)
+{
+}
+
+MovieRecordList::MovieRecordList(const MovieRecordList& other)
+	: count(0)
+	, lastChunk(0)
+	, prefixValid(0)
+{
+	*this = other;
+}
+
+MovieRecordList& MovieRecordList::operator=(const MovieRecordList& other)
+{
+	if (this == &other)
+		return *this;
+	clear();
+	for (size_t i = 0; i < other.chunks.size(); i++)
+		chunks.push_back(new Chunk(*other.chunks[i]));
+	starts = other.starts;
+	count = other.count;
+	blockHash = other.blockHash;
+	prefixHash = other.prefixHash;
+	blockValid = other.blockValid;
+	prefixValid = other.prefixValid;
+	return *this;
+}
+
+MovieRecordList::~MovieRecordList()
+{
+	clear();
+}
+
+void MovieRecordList::clear()
+{
+	for (size_t i = 0; i < chunks.size(); i++)
+		delete chunks[i];
+	chunks.clear();
+	starts.clear();
+	count = 0;
+	lastChunk = 0;
+	touchFrom(0);
+}
+
+void MovieRecordList::updateStarts(int from)
+{
+	starts.resize(chunks.size());
+	int frame = from > 0 ? starts[from - 1] + chunks[from - 1]->size() : 0;
+	for (int i = from; i < (int)chunks.size(); i++)
+	{
+		starts[i] = frame;
+		frame += chunks[i]->size();
+	}
+	count = frame;
+	if (lastChunk >= (int)chunks.size())
+		lastChunk = 0;
+}
+
+int MovieRecordList::findChunk(int frame) const
+{
+	//movies are mostly walked frame by frame, so try the last chunk and its successor first
+	int ci = lastChunk;
+	if (ci < (int)chunks.size() && frame >= starts[ci])
+	{
+		if (frame < starts[ci] + chunks[ci]->size())
+			return ci;
+		ci++;
+		if (ci < (int)chunks.size() && frame < starts[ci] + chunks[ci]->size())
+			return lastChunk = ci;
+	}
+	ci = (int)(std::upper_bound(starts.begin(), starts.end(), frame) - starts.begin()) - 1;
+	return lastChunk = ci;
+}
+
+//makes sure a chunk begins at 'frame' and returns its index (chunks.size() for the end of the list)
+int MovieRecordList::splitAt(int frame)
+{
+	if (frame >= count)
+		return (int)chunks.size();
+	int ci = findChunk(frame);
+	int ofs = frame - starts[ci];
+	if (ofs == 0)
+		return ci;
+
+	Chunk* left = chunks[ci];
+	Chunk* right = new Chunk();
+	right->joysticks.assign(left->joysticks.begin() + ofs * 4, left->joysticks.end());
+	right->commands.assign(left->commands.begin() + ofs, left->commands.end());
+	left->joysticks.resize(ofs * 4);
+	left->commands.resize(ofs);
+	if (!left->zappers.empty())
+	{
+		right->zappers.assign(left->zappers.begin() + ofs * 2, left->zappers.end());
+		left->zappers.resize(ofs * 2);
+	}
+	chunks.insert(chunks.begin() + ci + 1, right);
+	updateStarts(ci);
+	return ci + 1;
+}
+
+//joins chunk ci with its successor if the result fits in one chunk
+void MovieRecordList::merge(int ci)
+{
+	if (ci < 0 || ci + 1 >= (int)chunks.size())
+		return;
+	Chunk* left = chunks[ci];
+	Chunk* right = chunks[ci + 1];
+	if (left->size() + right->size() > CHUNK_FRAMES)
+		return;
+
+	if (!left->zappers.empty() || !right->zappers.empty())
+	{
+		MovieRecord::Zapper none = {};
+		left->zappers.resize(left->size() * 2, none);
+		right->zappers.resize(right->size() * 2, none);
+		left->zappers.insert(left->zappers.end(), right->zappers.begin(), right->zappers.end());
+	}
+	left->joysticks.insert(left->joysticks.end(), right->joysticks.begin(), right->joysticks.end());
+	left->commands.insert(left->commands.end(), right->commands.begin(), right->commands.end());
+	delete right;
+	chunks.erase(chunks.begin() + ci + 1);
+	updateStarts(ci);
+}
+
+void MovieRecordList::insert(int at, int frames)
+{
+	if (frames <= 0)
+		return;
+	if (at > count)
+		at = count;
+	touchFrom(at);
+
+	int ci = splitAt(at);
+	int first = ci;
+	while (frames > 0)
+	{
+		int n = std::min(frames, (int)CHUNK_FRAMES);
+		Chunk* c = new Chunk();
+		c->joysticks.resize(n * 4);
+		c->commands.resize(n);
+		chunks.insert(chunks.begin() + ci, c);
+		ci++;
+		frames -= n;
+	}
+	updateStarts(first);
+	merge(ci - 1);
+	merge(first - 1);
+}
+
+void MovieRecordList::insert(int at, const MovieRecord& mr)
+{
+	if (at >= count)
+	{
+		push_back(mr);
+		return;
+	}
+	touchFrom(at);
+
+	int ci = findChunk(at);
+	Chunk* c = chunks[ci];
+	int ofs = at - starts[ci];
+	c->joysticks.insert(c->joysticks.begin() + ofs * 4, mr.joysticks.data, mr.joysticks.data + 4);
+	c->commands.insert(c->commands.begin() + ofs, mr.commands);
+	if (!c->zappers.empty())
+		c->zappers.insert(c->zappers.begin() + ofs * 2, mr.zappers, mr.zappers + 2);
+	else if (ZappersUsed(mr))
+	{
+		MovieRecord::Zapper none = {};
+		c->zappers.resize(c->size() * 2, none);
+		c->zappers[ofs * 2] = mr.zappers[0];
+		c->zappers[ofs * 2 + 1] = mr.zappers[1];
+	}
+	updateStarts(ci);
+
+	if (c->size() > CHUNK_FRAMES)
+		splitAt(starts[ci] + c->size() / 2);
+}
+
+void MovieRecordList::erase(int at, int frames)
+{
+	if (at < 0 || at >= count || frames <= 0)
+		return;
+	if (at + frames > count)
+		frames = count - at;
+	touchFrom(at);
+
+	int first = splitAt(at);
+	int last = splitAt(at + frames);
+	for (int i = first; i < last; i++)
+		delete chunks[i];
+	chunks.erase(chunks.begin() + first, chunks.begin() + last);
+	updateStarts(first);
+	merge(first - 1);
+}
+
+void MovieRecordList::push_back(const MovieRecord& mr)
+{
+	touch(count);
+	if (chunks.empty() || chunks.back()->size() >= CHUNK_FRAMES)
+	{
+		chunks.push_back(new Chunk());
+		starts.push_back(count);
+	}
+	Chunk* c = chunks.back();
+	c->joysticks.insert(c->joysticks.end(), mr.joysticks.data, mr.joysticks.data + 4);
+	c->commands.push_back(mr.commands);
+	if (!c->zappers.empty())
+		c->zappers.insert(c->zappers.end(), mr.zappers, mr.zappers + 2);
+	else if (ZappersUsed(mr))
+	{
+		MovieRecord::Zapper none = {};
+		c->zappers.resize(c->size() * 2 - 2, none);
+		c->zappers.insert(c->zappers.end(), mr.zappers, mr.zappers + 2);
+	}
+	count++;
+}
+
+void MovieRecordList::resize(int frames)
+{
+	if (frames < count)
+		erase(frames, count - frames);
+	else if (frames > count)
+	{
+		touchFrom(count);
+		//fill up the last chunk before adding new ones
+		if (!chunks.empty())
+		{
+			Chunk* c = chunks.back();
+			int n = std::min(frames - count, CHUNK_FRAMES - c->size());
+			if (n > 0)
+			{
+				c->joysticks.resize((c->size() + n) * 4);
+				c->commands.resize(c->size() + n);
+				if (!c->zappers.empty())
+				{
+					MovieRecord::Zapper none = {};
+					c->zappers.resize(c->size() * 2, none);
+				}
+				count += n;
+			}
+		}
+		insert(count, frames - count);
+	}
+}
+
+void MovieRecordList::get(int frame, MovieRecord& mr) const
+{
+	int ci = findChunk(frame);
+	const Chunk* c = chunks[ci];
+	int ofs = frame - starts[ci];
+	memcpy(mr.joysticks.data, &c->joysticks[ofs * 4], 4);
+	mr.commands = c->commands[ofs];
+	if (c->zappers.empty())
+		memset(mr.zappers, 0, sizeof(mr.zappers));
+	else
+		memcpy(mr.zappers, &c->zappers[ofs * 2], sizeof(mr.zappers));
+}
+
+void MovieRecordList::set(int frame, const MovieRecord& mr)
+{
+	touch(frame);
+	int ci = findChunk(frame);
+	Chunk* c = chunks[ci];
+	int ofs = frame - starts[ci];
+	memcpy(&c->joysticks[ofs * 4], mr.joysticks.data, 4);
+	c->commands[ofs] = mr.commands;
+	if (!c->zappers.empty() || ZappersUsed(mr))
+	{
+		MovieRecord::Zapper none = {};
+		c->zappers.resize(c->size() * 2, none);
+		memcpy(&c->zappers[ofs * 2], mr.zappers, sizeof(mr.zappers));
+	}
+}
+
+MovieRecordRef MovieRecordList::operator[](int frame)
+{
+	//the reference may be written through, so assume it is
+	touch(frame);
+	int ci = findChunk(frame);
+	Chunk* c = chunks[ci];
+	int ofs = frame - starts[ci];
+	return MovieRecordRef(&c->joysticks[ofs * 4], c->commands[ofs], MovieRecordRef::ZapperRef(&c->zappers, c->size(), ofs));
+}
+
+//drops the hash of the block that contains 'frame'
+void MovieRecordList::touch(int frame)
+{
+	int block = frame / HASH_FRAMES;
+	if (block < (int)blockValid.size())
+		blockValid[block] = false;
+	if (prefixValid > block)
+		prefixValid = block;
+}
+
+//drops the hashes of all blocks from the one that contains 'frame' on, for edits that shift frames
+void MovieRecordList::touchFrom(int frame)
+{
+	int block = frame / HASH_FRAMES;
+	if (block < (int)blockValid.size())
+		blockValid.resize(block);
+	if (prefixValid > block)
+		prefixValid = block;
+}
+
+static inline uint64 HashMix(uint64 h, uint64 v)
+{
+	h ^= v * 0xC2B2AE3D27D4EB4FULL;
+	h = (h << 31) | (h >> 33);
+	return h * 0x9E3779B97F4A7C15ULL;
+}
+
+uint64 MovieRecordList::hashBlock(int block) const
+{
+	int frame = block * HASH_FRAMES;
+	int last = std::min(frame + (int)HASH_FRAMES, count);
+	uint64 h = 0x27D4EB2F165667C5ULL;
+	if (frame >= last)
+		return h;
+
+	int ci = findChunk(frame);
+	int ofs = frame - starts[ci];
+	while (frame < last)
+	{
+		const Chunk* c = chunks[ci];
+		int n = std::min(c->size() - ofs, last - frame);
+		for (int i = ofs; i < ofs + n; i++)
+		{
+			uint32 joy;
+			memcpy(&joy, &c->joysticks[i * 4], 4);
+			h = HashMix(h, joy | ((uint64)c->commands[i] << 32));
+			//zapper data only counts when it is set, so that chunks with and without a zapper column agree
+			if (!c->zappers.empty())
+			{
+				const MovieRecord::Zapper* z = &c->zappers[i * 2];
+				for (int w = 0; w < 2; w++)
+					if (z[w].x | z[w].y | z[w].b | z[w].bogo | z[w].zaphit)
+						h = HashMix(HashMix(h, z[w].x | (z[w].y << 8) | (z[w].b << 16) | (z[w].bogo << 24) | ((uint64)(w + 1) << 32)), z[w].zaphit);
+			}
+		}
+		frame += n;
+		ofs = 0;
+		ci++;
+	}
+	return h;
+}
+
+//makes the prefix hashes of the first 'blocks' blocks valid
+void MovieRecordList::updateHashes(int blocks) const
+{
+	if (blocks <= prefixValid)
+		return;
+	if ((int)blockHash.size() < blocks)
+	{
+		blockHash.resize(blocks);
+		prefixHash.resize(blocks);
+	}
+	if ((int)blockValid.size() < blocks)
+		blockValid.resize(blocks, false);
+
+	for (int k = prefixValid; k < blocks; k++)
+	{
+		if (!blockValid[k])
+		{
+			blockHash[k] = hashBlock(k);
+			blockValid[k] = true;
+		}
+		prefixHash[k] = HashMix(k ? prefixHash[k - 1] : 0, blockHash[k]);
+	}
+	prefixValid = blocks;
+}
+
+int MovieRecordList::firstDifference(const MovieRecordList& other, int end) const
+{
+	//find the first whole block whose prefix hash differs; everything before it is the same
+	int blocks = end / HASH_FRAMES;
+	updateHashes(blocks);
+	other.updateHashes(blocks);
+
+	int lo = 0, hi = blocks;
+	while (lo < hi)
+	{
+		int mid = (lo + hi) / 2;
+		if (prefixHash[mid] == other.prefixHash[mid])
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+
+	MovieRecord a, b;
+	for (int frame = lo * HASH_FRAMES; frame < end; frame++)
+	{
+		get(frame, a);
+		other.get(frame, b);
+		if (!a.Compare(b))
+			return frame;
+	}
+	return -1;
+}
+
+size_t MovieRecordList::memoryUsage() const
+{
+	size_t total = chunks.size() * (sizeof(Chunk) + sizeof(Chunk*) + sizeof(int));
+	for (size_t i = 0; i < chunks.size(); i++)
+		total += chunks[i]->joysticks.capacity() + chunks[i]->commands.capacity() + chunks[i]->zappers.capacity() * sizeof(MovieRecord::Zapper);
+	return total;
+}
+
+// ----------------------------------------------------------------------------
 MovieData::MovieData()
 	: version(MOVIE_VERSION)
 	, emuVersion(FCEU_VERSION_NUMERIC)
@@ -522,19 +965,23 @@ int MovieData::dump(EMUFILE *os, bool binary, bool seekToCurrFramePos)
 	{
 		//put one | to start the binary dump
 		os->fputc('|');
-		for (int i = 0; i < (int)records.size(); i++)
+		MovieRecord mr;
+		for (int i = 0; i < records.size(); i++)
 		{
 			if (seekToCurrFramePos && currFrameCounter == i)
 				currFramePos = os->ftell();
-			records[i].dumpBinary(this, os, i);
+			records.get(i, mr);
+			mr.dumpBinary(this, os, i);
 		}
 	} else
 	{
-		for (int i = 0; i < (int)records.size(); i++)
+		MovieRecord mr;
+		for (int i = 0; i < records.size(); i++)
 		{
 			if (seekToCurrFramePos && currFrameCounter == i)
 				currFramePos = os->ftell();
-			records[i].dump(this, os, i);
+			records.get(i, mr);
+			mr.dump(this, os, i);
 		}
 	}
 
@@ -625,13 +1072,222 @@ static void LoadFM2_binarychunk(MovieData& movieData, EMUFILE* fp, int size)
 	if (movieData.loadFrameCount!=-1 && movieData.loadFrameCount<numRecords)
 		numRecords=movieData.loadFrameCount;
 
-	movieData.records.resize(numRecords);
+	movieData.records.clear();
 	for(int i=0;i<numRecords;i++)
 	{
-		movieData.records[i].parseBinary(&movieData,fp);
+		MovieRecord mr;
+		mr.parseBinary(&movieData,fp);
+		movieData.records.push_back(mr);
 	}
 }
 
+//parse tables for the bulk text record decoder
+static u8 fm2JoyPressed[256];
+static bool fm2TablesReady = false;
+#ifdef _DEBUG
+static void FM2_TestZapperRoundTrip();
+#endif
+
+static void FM2_InitTables()
+{
+	if (fm2TablesReady) return;
+	for (int i = 0; i < 256; i++)
+		fm2JoyPressed[i] = (i == '.' || i == ' ') ? 0 : 1;
+	fm2TablesReady = true;
+#ifdef _DEBUG
+	FM2_TestZapperRoundTrip();
+#endif
+}
+
+//reads an unsigned decimal the way uint32DecFromIstream()/uint64DecFromIstream() do (T picks which),
+//but needs at least one digit right at p
+template<typename T>
+static bool FM2_ParseDec(const u8*& p, const u8* end, T& val)
+{
+	T ret = 0;
+	const u8* q = p;
+	while (q < end && (unsigned)(*q - '0') <= 9)
+		ret = ret * 10 + (*q++ - '0');
+	if (q == p) return false;
+	val = ret;
+	p = q;
+	return true;
+}
+
+static bool FM2_ParseJoy(const u8*& p, const u8* end, uint8& joystate)
+{
+	if (end - p < 9 || p[8] != '|') return false;
+	joystate = (fm2JoyPressed[p[0]] << 7) | (fm2JoyPressed[p[1]] << 6) | (fm2JoyPressed[p[2]] << 5) | (fm2JoyPressed[p[3]] << 4)
+	         | (fm2JoyPressed[p[4]] << 3) | (fm2JoyPressed[p[5]] << 2) | (fm2JoyPressed[p[6]] << 1) | fm2JoyPressed[p[7]];
+	p += 9;
+	return true;
+}
+
+//decodes one text record with the field layout of MovieRecord::parse() (the leading | already skipped).
+//returns false if the record is not in the exact layout that MovieRecord::dump() writes, so the caller
+//can fall back to MovieRecord::parse()
+static bool FM2_ParseRecord(MovieData& md, const u8*& pos, const u8* end, MovieRecord& mr)
+{
+	const u8* p = pos;
+	uint32 val;
+
+	if (!FM2_ParseDec(p, end, val) || p == end || *p != '|') return false;
+	mr.commands = (uint8)val;
+	p++;
+
+	if (md.fourscore)
+	{
+		for (int i = 0; i < 4; i++)
+			if (!FM2_ParseJoy(p, end, mr.joysticks[i])) return false;
+	}
+	else
+	{
+		for (int port = 0; port < 2; port++)
+		{
+			if (md.ports[port] == SI_GAMEPAD)
+			{
+				if (!FM2_ParseJoy(p, end, mr.joysticks[port])) return false;
+				continue;
+			}
+			else if (md.ports[port] == SI_ZAPPER)
+			{
+				uint32 fields[4];
+				for (int i = 0; i < 4; i++)
+				{
+					if (!FM2_ParseDec(p, end, fields[i]) || p == end || *p != ' ') return false;
+					p++;
+				}
+				//zaphit carries the zapper timestamp, which passes 2^32 in long movies
+				uint64 zaphit;
+				if (!FM2_ParseDec(p, end, zaphit) || p == end || *p != '|') return false;
+				p++;
+				mr.zappers[port].x = fields[0];
+				mr.zappers[port].y = fields[1];
+				mr.zappers[port].b = fields[2];
+				mr.zappers[port].bogo = fields[3];
+				mr.zappers[port].zaphit = zaphit;
+				continue;
+			}
+			if (p == end || *p != '|') return false;
+			p++;
+		}
+	}
+
+	//(no fcexp data is logged right now)
+	if (p == end || *p != '|') return false;
+	pos = p + 1;
+	return true;
+}
+
+#ifdef _DEBUG
+//round-trips a zapper record through dump() and both parsers, so the fast path can't quietly narrow a field.
+//zaphit is past 2^32, as it is in any zapper movie longer than about 40 minutes
+static void FM2_TestZapperRoundTrip()
+{
+	MovieData md;
+	md.fourscore = false;
+	md.ports[0] = SI_ZAPPER;
+	md.ports[1] = SI_GAMEPAD;
+
+	MovieRecord in;
+	in.commands = MOVIECMD_RESET;
+	in.joysticks[1] = 0x81;
+	in.zappers[0].x = 200;
+	in.zappers[0].y = 117;
+	in.zappers[0].b = 1;
+	in.zappers[0].bogo = 1;
+	in.zappers[0].zaphit = 0x123456789ULL;
+
+	std::vector<u8> buf;
+	EMUFILE_MEMORY os(&buf);
+	in.dump(&md, &os, 0);
+
+	MovieRecord fast;
+	const u8* p = &buf[1];
+	bool parsed = FM2_ParseRecord(md, p, &buf[0] + buf.size(), fast);
+
+	MovieRecord ref;
+	EMUFILE_MEMORY is(&buf);
+	is.fseek(1, SEEK_SET);
+	ref.parse(&md, &is);
+
+	assert(parsed && *p == '\n');
+	assert(ref.Compare(in) && fast.Compare(in));
+}
+#endif
+
+//loads a run of text records from one buffered read instead of going through the character state machine.
+//called with the leading | of the first record already consumed. returns true if loading is finished;
+//otherwise fp is left at the first character that is not part of a record, for the header parser.
+static bool LoadFM2_textchunk(MovieData& movieData, EMUFILE* fp, int& size)
+{
+	FM2_InitTables();
+
+	//never look past the caller's bound: the movie may be embedded in a larger stream (e.g. a savestate)
+	int start = fp->ftell();
+	int avail = std::min(fp->size() - start, size);
+	std::vector<u8> buf(std::max(avail, 0));
+	if (avail > 0)
+		fp->fread(&buf[0], avail);
+	EMUFILE_MEMORY mem(&buf);
+
+	const u8* base = buf.empty() ? NULL : &buf[0];
+	const u8* end = base + buf.size();
+	const u8* p = base;
+	bool finished = false;
+
+	for(;;)
+	{
+		MovieRecord mr;
+		if (!FM2_ParseRecord(movieData, p, end, mr))
+		{
+			//not in the usual layout, let the reference parser deal with it
+			mr = MovieRecord();
+			mem.fseek((int)(p - base), SEEK_SET);
+			mr.parse(&movieData, &mem);
+			p = base + mem.ftell();
+		}
+		movieData.records.push_back(mr);
+
+		//what the NEWLINE state of LoadFM2 does between records
+		bool another = false;
+		while (!another)
+		{
+			if (p == end)
+			{
+				finished = true;
+				break;
+			}
+			u8 c = *p;
+			if (c == '\n' || c == '\r')
+			{
+				p++;
+				if (movieData.loadFrameCount == movieData.records.size())
+				{
+					finished = true;
+					break;
+				}
+			}
+			else if (c == ' ' || c == '\t')
+				p++;
+			else if (c == '|')
+			{
+				p++;
+				another = true;
+			}
+			else
+				break; //start of a key
+		}
+		if (!another)
+			break;
+	}
+
+	int consumed = (int)(p - base);
+	size -= consumed;
+	fp->fseek(start + consumed, SEEK_SET);
+	return finished;
+}
+
 //yuck... another custom text parser.
 bool LoadFM2(MovieData& movieData, EMUFILE* fp, int size, bool stopAfterHeader)
 {
@@ -702,12 +1358,8 @@ bool LoadFM2(MovieData& movieData, EMUFILE* fp, int size, bool stopAfterHeader)
 			{
 				dorecord:
 				if (stopAfterHeader) return true;
-				int currcount = movieData.records.size();
-				movieData.records.resize(currcount+1);
-				int preparse = fp->ftell();
-				movieData.records[currcount].parse(&movieData, fp);
-				int postparse = fp->ftell();
-				size -= (postparse-preparse);
+				if (LoadFM2_textchunk(movieData, fp, size))
+					return true;
 				state = NEWLINE;
 				break;
 			}
@@ -789,11 +1441,15 @@ static EMUFILE *openRecordingMovie(const char* fname)
 	if (osRecordingMovie)
 		delete osRecordingMovie;
 
-	osRecordingMovie = FCEUD_UTF8_fstream(fname, "wb");
-	if (!osRecordingMovie || osRecordingMovie->fail()) {
+	osRecordingMovie = NULL;
+	EMUFILE* file = FCEUD_UTF8_fstream(fname, "wb");
+	if (!file || file->fail()) {
+		delete file;
 		FCEU_PrintError("Error opening movie output file: %s", fname);
 		return NULL;
 	}
+	//frames are appended every frame while recording, so keep the disk writes off the emulation thread
+	osRecordingMovie = new EMUFILE_ASYNC(file);
 	strcpy(curMovieFilename, fname);
 
 	return osRecordingMovie;
@@ -1183,14 +1839,18 @@ void FCEUMOV_AddInputState()
 		if (((int)currMovieData.records.size() - 1) < (currFrameCounter + 1))
 			currMovieData.insertEmpty(-1, (currFrameCounter + 1) - ((int)currMovieData.records.size() - 1));
 
-		MovieRecord* mr = &currMovieData.records[currFrameCounter];
+		MovieRecord record;
+		MovieRecord* mr = &record;
+		currMovieData.records.get(currFrameCounter, record);
 		if (isTaseditorRecording())
 		{
 			// record commands and buttons
 			mr->commands |= _currCommand;
 			joyports[0].log(mr);
 			joyports[1].log(mr);
+			currMovieData.records.set(currFrameCounter, record);
 			recordInputByTaseditor();
+			currMovieData.records.get(currFrameCounter, record);
 		}
 		// replay buttons
 		joyports[0].load(mr);
@@ -1221,7 +1881,9 @@ void FCEUMOV_AddInputState()
 			portFC.driver->Update(portFC.ptr,portFC.attrib);
 		} else
 		{
-			MovieRecord* mr = &currMovieData.records[currFrameCounter];
+			MovieRecord record;
+			MovieRecord* mr = &record;
+			currMovieData.records.get(currFrameCounter, record);
 
 			//reset and power cycle if necessary
 			if(mr->command_power())
@@ -1270,11 +1932,10 @@ void FCEUMOV_AddInputState()
 			switch (movieRecordMode)
 			{
 			case MOVIE_RECORD_MODE_OVERWRITE:
-				currMovieData.records[currFrameCounter].Clone(mr);
+				currMovieData.records.set(currFrameCounter, mr);
 				break;
 			case MOVIE_RECORD_MODE_INSERT:
-				//FIXME: this could be very insufficient
-				currMovieData.records.insert(currMovieData.records.begin() + currFrameCounter, mr);
+				currMovieData.records.insert(currFrameCounter, mr);
 				break;
 			//case MOVIE_RECORD_MODE_TRUNCATE:
 			default:
@@ -1390,13 +2051,7 @@ int CheckTimelines(MovieData& stateMovie, MovieData& currMovie)
 	if (end_frame > currFrameCounter)
 		end_frame = currFrameCounter;
 
-	for (int x = 0; x < end_frame; x++)
-	{
-		if (!stateMovie.records[x].Compare(currMovie.records[x]))
-			return x;
-	}
-	// no mismatch found
-	return -1;
+	return stateMovie.records.firstDifference(currMovie.records, end_frame);
 }
 
 
@@ -1775,8 +2430,7 @@ void FCEUI_MovieInsertFrame()
 	{
 		strcpy(message, "1 frame inserted");
 		strcat(message, GetMovieModeStr());
-		std::vector<MovieRecord>::iterator iter = currMovieData.records.begin();
-		currMovieData.records.insert(iter + currFrameCounter, MovieRecord());
+		currMovieData.records.insert(currFrameCounter, 1);
 		FCEUMOV_IncrementRerecordCount();
 		RedumpWholeMovieFile();
 	} else
@@ -1801,8 +2455,7 @@ void FCEUI_MovieDeleteFrame()
 	else if (movieMode == MOVIEMODE_RECORD || movieMode == MOVIEMODE_PLAY)
 	{
 		strcpy(message, "1 frame deleted");
-		std::vector<MovieRecord>::iterator iter = currMovieData.records.begin();
-		currMovieData.records.erase(iter + currFrameCounter);
+		currMovieData.records.erase(currFrameCounter);
 		FCEUMOV_IncrementRerecordCount();
 		RedumpWholeMovieFile();
 
@@ -1889,6 +2542,33 @@ void FCEUI_MovieRecordModeInsert()
 	movieRecordMode = MOVIE_RECORD_MODE_INSERT;
 }
 
+//Plays back the input of a movie from the current emulator state, read-only, without the power-on or
+//savestate load FCEUI_LoadMovie does first. Used to replay a movie suffix on top of a prepared state.
+bool FCEUMOV_PlayInputFrom(const char *fname)
+{
+	if(movieMode == MOVIEMODE_PLAY || movieMode == MOVIEMODE_FINISHED)
+		StopPlayback();
+	else if(movieMode == MOVIEMODE_RECORD)
+		StopRecording();
+
+	currMovieData = MovieData();
+	FCEUFILE *fp = FCEU_fopen(fname,0,"rb",0);
+	if (!fp) return false;
+	bool success = LoadFM2(currMovieData, fp->stream, fp->size, false);
+	delete fp;
+	if (!success) return false;
+
+	//the ports have to match the movie's, as in FCEUI_LoadMovie, or zapper/fourscore/microphone input desyncs
+	FCEUD_SetInput(currMovieData.fourscore, currMovieData.microphone, (ESI)currMovieData.ports[0], (ESI)currMovieData.ports[1], (ESIFC)currMovieData.ports[2]);
+
+	strcpy(curMovieFilename, fname);
+	currFrameCounter = 0;
+	pauseframe = 0;
+	movie_readonly = true;
+	movieMode = MOVIEMODE_PLAY;
+	return true;
+}
+
 void FCEUI_MoviePlayFromBeginning(void)
 {
 	if (movieMode == MOVIEMODE_TASEDITOR)
@@ -117,7 +117,7 @@ public:
 	MovieRecord();
 	ValueArray<uint8,4> joysticks;
 
-	struct {
+	struct Zapper {
 		uint8 x,y,b,bogo;
 		uint64 zaphit;
 	} zappers[2];
@@ -175,6 +175,106 @@ private:
 	int mask(int bit) { return 1<<bit; }
 };
 
+//a reference to one frame stored in a MovieRecordList.
+//it offers the same fields and bit helpers as a MovieRecord, but is only valid until the list changes size.
+class MovieRecordRef
+{
+public:
+	class ZapperRef
+	{
+	public:
+		ZapperRef(std::vector<MovieRecord::Zapper>* column, int count, int index) : column(column), count(count), index(index) {}
+		//allocates the zapper column of the chunk on first use
+		MovieRecord::Zapper& operator[](int w);
+		void clear();
+	private:
+		std::vector<MovieRecord::Zapper>* column;
+		int count, index;
+	};
+
+	MovieRecordRef(uint8* joysticks, uint8& commands, const ZapperRef& zappers) : joysticks(joysticks), commands(commands), zappers(zappers) {}
+
+	uint8* joysticks;
+	uint8& commands;
+	ZapperRef zappers;
+
+	bool command_reset() { return (commands & MOVIECMD_RESET) != 0; }
+	bool command_power() { return (commands & MOVIECMD_POWER) != 0; }
+	bool command_fds_insert() { return (commands & MOVIECMD_FDS_INSERT) != 0; }
+	bool command_fds_select() { return (commands & MOVIECMD_FDS_SELECT) != 0; }
+	bool command_vs_insertcoin() { return (commands & MOVIECMD_VS_INSERTCOIN) != 0; }
+
+	void toggleBit(int joy, int bit) { joysticks[joy] ^= (1<<bit); }
+	void setBit(int joy, int bit) { joysticks[joy] |= (1<<bit); }
+	void clearBit(int joy, int bit) { joysticks[joy] &= ~(1<<bit); }
+	void setBitValue(int joy, int bit, bool val) { if(val) setBit(joy,bit); else clearBit(joy,bit); }
+	bool checkBit(int joy, int bit) { return (joysticks[joy] & (1<<bit))!=0; }
+
+	void clear();
+};
+
+//the frame storage of a MovieData.
+//frames are kept in columns (4 joystick bytes and 1 command byte per frame), and zapper data is only
+//allocated for chunks in which some frame uses it. the columns are split into chunks of at most
+//CHUNK_FRAMES frames, so inserting or erasing frames anywhere only moves the data of one chunk.
+class MovieRecordList
+{
+public:
+	enum { CHUNK_FRAMES = 4096 };
+
+	MovieRecordList();
+	MovieRecordList(const MovieRecordList& other);
+	MovieRecordList& operator=(const MovieRecordList& other);
+	~MovieRecordList();
+
+	int size() const { return count; }
+	bool empty() const { return count == 0; }
+	void clear();
+	void resize(int frames);
+
+	//inserts empty frames before frame 'at'
+	void insert(int at, int frames);
+	void insert(int at, const MovieRecord& mr);
+	void erase(int at, int frames = 1);
+	void push_back(const MovieRecord& mr);
+
+	void get(int frame, MovieRecord& mr) const;
+	void set(int frame, const MovieRecord& mr);
+	MovieRecordRef operator[](int frame);
+
+	//bytes used by the frame data
+	size_t memoryUsage() const;
+
+	//returns the first frame below 'end' in which the two lists differ, or -1.
+	//both lists need at least 'end' frames.
+	int firstDifference(const MovieRecordList& other, int end) const;
+
+private:
+	struct Chunk;
+	std::vector<Chunk*> chunks;
+	std::vector<int> starts; //first frame of each chunk
+	int count;
+	mutable int lastChunk;
+
+	//content hashes of HASH_FRAMES sized blocks, and of all blocks up to and including each block.
+	//they are computed on demand; edits only drop the hashes of the blocks they touch, or of
+	//everything after the edit point if frames were shifted.
+	enum { HASH_FRAMES = 256 };
+	mutable std::vector<uint64> blockHash, prefixHash;
+	mutable std::vector<bool> blockValid;
+	mutable int prefixValid;
+
+	int findChunk(int frame) const;
+	int splitAt(int frame);
+	void merge(int ci);
+	void updateStarts(int from);
+
+	void touch(int frame);
+	void touchFrom(int frame);
+	uint64 hashBlock(int block) const;
+	void updateHashes(int blocks) const;
+};
+
 class MovieData
 {
 public:
@@ -191,7 +291,7 @@ public:
 	std::string romFilename;
 	std::vector<uint8> savestate;
 	std::vector<uint8> saveram;
-	std::vector<MovieRecord> records;
+	MovieRecordList records;
 	std::vector<std::wstring> comments;
 	std::vector<std::string> subtitles;
 	//this is the RERECORD COUNT. please rename variable.
@@ -284,6 +384,7 @@ void FCEUI_MakeBackupMovie(bool dispMessage);
 void FCEUI_CreateMovieFile(std::string fn);
 void FCEUI_SaveMovie(const char *fname, EMOVIE_FLAG flags, std::wstring author);
 bool FCEUI_LoadMovie(const char *fname, bool read_only, int _stopframe);
+bool FCEUMOV_PlayInputFrom(const char *fname);
 void FCEUI_MoviePlayFromBeginning(void);
 void FCEUI_StopMovie(void);
 bool FCEUI_MovieGetInfo(FCEUFILE* fp, MOVIE_INFO& info, bool skipFrameCount = false);
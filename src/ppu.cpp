@@ -1296,6 +1296,13 @@ static void DoLine(void) {
 	X6502_Run(256);
 	EndRL();
 
+	//background and sprite line buffers are all the cpu can observe (sprite 0, zapper), the rest is output
+	if (computeOnly) {
+		if (SpriteON)
+			spork = 0;	//consumed as CopySprites would
+		goto nooutput;
+	}
+
 	if (!renderbg) {// User asked to not display background data.
 		uint32 tem;
 		uint8 col;
@@ -1334,6 +1341,7 @@ static void DoLine(void) {
 	for (x = 63; x >= 0; x--)
 		*(uint32*)&dtarget[x << 2] = ((PPU[1]>>5)<<0)|((PPU[1]>>5)<<8)|((PPU[1]>>5)<<16)|((PPU[1]>>5)<<24);
 
+nooutput:
 	sphitx = 0x100;
 
 	if (ScreenON || SpriteON)
@@ -2096,6 +2104,9 @@ int FCEUX_PPU_Loop(int skip) {
 		static int oamslot = 0;
 		static int oamcount;
 
+		//compute-only mode draws nothing, unless a zapper is plugged in: it senses light by reading XBuf
+		const bool drawPixels = !computeOnly || joyports[0].type == SI_ZAPPER || joyports[1].type == SI_ZAPPER;
+
 		//capture the initial xscroll
 		//int xscroll = ppur.fh;
 		//render 241/291 scanlines (1 dummy at beginning, dendy's 50 at the end)
@@ -2135,6 +2146,31 @@ int FCEUX_PPU_Loop(int skip) {
 			for (int xt = 0; xt < 32; xt++) {
 				bgdata.main[xt + 2].Read();
 
+				if (!drawPixels) {
+					//all the cpu can see of these 8px is a sprite 0 hit. sprite 0 is always evaluated into the
+					//first slot, so no other sprite can take the pixel from it
+					const uint8* oam = oams[renderslot][0];
+					if (sl != 0 && sl < 241 && oamcount && oam[6] == 0 && !(PPU_status & 0x40)
+						&& SpriteON && ScreenON && (xt > 0 || (SpriteLeft8 && BGLeft8))) {
+						const int xstart = xt << 3;
+						const int x = oam[3];
+						int first = x > xstart ? x : xstart;
+						int last = x + 8 < xstart + 8 ? x + 8 : xstart + 8;
+						if (last > 255) last = 255;
+						for (int rasterpos = first; rasterpos < last; rasterpos++) {
+							const int bgpos = rasterpos + ppur.fh;
+							const uint8* pt = bgdata.main[bgpos >> 3].pt;
+							if ((((pt[0] | pt[1]) >> (7 - (bgpos & 7))) & ((oam[4] | oam[5]) >> (rasterpos - x)) & 1) != 0) {
+								PPU_status |= 0x40;
+								break;
+							}
+						}
+					}
+					if (sl != 0 && sl < 241)
+						g_rasterpos += 8;
+					continue;
+				}
+
 				const uint8 blank = (gNoBGFillColor == 0xFF) ? READPAL(0) : gNoBGFillColor;
 
 				//ok, we're also going to draw here.
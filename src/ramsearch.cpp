@@ -0,0 +1,333 @@
+// Platform-neutral RAM search. All cheat-visible memory (internal RAM and
+// cartridge WRAM/SRAM, as registered through FCEU_CheatAddRAM) is copied into a
+// contiguous snapshot, and the candidates are kept as a bitset over snapshot
+// offsets, so a filter pass is a straight sweep over two small buffers that
+// skips eliminated 64-address blocks entirely.
+
+#include "types.h"
+#include "fceu.h"
+#include "cheat.h"
+#include "driver.h"
+
+#include <vector>
+#include <cstring>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+// snapshots are padded so the wide loads for the last candidate block stay in bounds
+#define RS_PAD 96
+
+struct RamSearchRegion
+{
+	uint32 addr;	// first cpu address
+	uint32 ofs;		// offset into the snapshots
+	uint32 size;
+	uint8 *mem;
+};
+
+static std::vector<RamSearchRegion> regions;
+static std::vector<uint8> snapshots[2];
+static std::vector<uint64> candidates;	// bit n set: the value starting at snapshot offset n is still a candidate
+static uint32 total = 0;
+static int previous = 0;				// which snapshot holds the values of the last search
+static int valueSize = 1;
+static bool valueSigned = false;
+
+static void TakeSnapshot(uint8 *dest)
+{
+	for (size_t i = 0; i < regions.size(); i++)
+		memcpy(dest + regions[i].ofs, regions[i].mem, regions[i].size);
+}
+
+static INLINE uint32 ReadRaw(const uint8 *p, int size)
+{
+	uint32 v = p[0];
+	if (size > 1) v |= p[1] << 8;
+	if (size > 2) v |= (p[2] << 16) | ((uint32)p[3] << 24);
+	return v;
+}
+
+static INLINE int64 RawToValue(uint32 raw, int size, bool sign)
+{
+	if (!sign)
+		return raw;
+	int shift = 32 - size * 8;
+	return (int32)(raw << shift) >> shift;
+}
+
+static INLINE int PopCount(uint64 x)
+{
+	x = x - ((x >> 1) & 0x5555555555555555ULL);
+	x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+	x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+	return (int)((x * 0x0101010101010101ULL) >> 56);
+}
+
+// ordering tests are done on keys: the raw value with the sign bit flipped for
+// signed searches, which makes unsigned comparison give the signed order
+static INLINE bool TestKeys(int op, uint32 a, uint32 b)
+{
+	switch (op)
+	{
+	case FCEU_RS_LESS:         return a < b;
+	case FCEU_RS_GREATER:      return a > b;
+	case FCEU_RS_LESSEQUAL:    return a <= b;
+	case FCEU_RS_GREATEREQUAL: return a >= b;
+	case FCEU_RS_EQUAL:        return a == b;
+	default:                   return a != b;
+	}
+}
+
+template<int S> static void FilterScalar(const uint8 *cur, const uint8 *prev, int op, bool specific, uint32 value)
+{
+	const uint32 mask = S == 4 ? 0xFFFFFFFF : (1u << (S * 8)) - 1;
+	const uint32 bias = valueSigned ? 1u << (S * 8 - 1) : 0;
+
+	for (size_t w = 0; w < candidates.size(); w++)
+	{
+		uint64 c = candidates[w];
+		if (!c)
+			continue;
+		uint64 keep = 0;
+		for (int j = 0; j < 64; j++)
+		{
+			if (!(c & ((uint64)1 << j)))
+				continue;
+			uint32 ofs = (uint32)w * 64 + j;
+			uint32 a = ReadRaw(cur + ofs, S);
+			bool pass;
+			if (op == FCEU_RS_DIFFERENTBY)
+				pass = ((a - ReadRaw(prev + ofs, S)) & mask) == (value & mask);
+			else
+				pass = TestKeys(op, a ^ bias, ((specific ? value : ReadRaw(prev + ofs, S)) & mask) ^ bias);
+			if (pass)
+				keep |= (uint64)1 << j;
+		}
+		candidates[w] = c & keep;
+	}
+}
+
+#ifdef __SSE2__
+
+// LoadValues gathers the values starting at p, p+1, ... p+lanes-1 into one
+// register, so every byte offset is a candidate, aligned or not.
+template<int S> struct RamSearchSSE2;
+
+template<> struct RamSearchSSE2<1>
+{
+	enum { lanes = 16 };
+	static INLINE __m128i LoadValues(const uint8 *p) { return _mm_loadu_si128((const __m128i*)p); }
+	static INLINE __m128i Splat(uint32 v) { return _mm_set1_epi8((char)v); }
+	static INLINE __m128i Sub(__m128i a, __m128i b) { return _mm_sub_epi8(a, b); }
+	static INLINE __m128i Gt(__m128i a, __m128i b) { return _mm_cmpgt_epi8(a, b); }
+	static INLINE __m128i Eq(__m128i a, __m128i b) { return _mm_cmpeq_epi8(a, b); }
+	static INLINE uint32 Bits(__m128i m) { return _mm_movemask_epi8(m); }
+};
+
+template<> struct RamSearchSSE2<2>
+{
+	enum { lanes = 8 };
+	static INLINE __m128i LoadValues(const uint8 *p)
+	{
+		return _mm_unpacklo_epi8(_mm_loadu_si128((const __m128i*)p), _mm_loadu_si128((const __m128i*)(p + 1)));
+	}
+	static INLINE __m128i Splat(uint32 v) { return _mm_set1_epi16((short)v); }
+	static INLINE __m128i Sub(__m128i a, __m128i b) { return _mm_sub_epi16(a, b); }
+	static INLINE __m128i Gt(__m128i a, __m128i b) { return _mm_cmpgt_epi16(a, b); }
+	static INLINE __m128i Eq(__m128i a, __m128i b) { return _mm_cmpeq_epi16(a, b); }
+	static INLINE uint32 Bits(__m128i m) { return _mm_movemask_epi8(_mm_packs_epi16(m, _mm_setzero_si128())); }
+};
+
+template<> struct RamSearchSSE2<4>
+{
+	enum { lanes = 4 };
+	static INLINE __m128i LoadValues(const uint8 *p)
+	{
+		__m128i lo = _mm_unpacklo_epi8(_mm_loadu_si128((const __m128i*)p), _mm_loadu_si128((const __m128i*)(p + 1)));
+		__m128i hi = _mm_unpacklo_epi8(_mm_loadu_si128((const __m128i*)(p + 2)), _mm_loadu_si128((const __m128i*)(p + 3)));
+		return _mm_unpacklo_epi16(lo, hi);
+	}
+	static INLINE __m128i Splat(uint32 v) { return _mm_set1_epi32((int)v); }
+	static INLINE __m128i Sub(__m128i a, __m128i b) { return _mm_sub_epi32(a, b); }
+	static INLINE __m128i Gt(__m128i a, __m128i b) { return _mm_cmpgt_epi32(a, b); }
+	static INLINE __m128i Eq(__m128i a, __m128i b) { return _mm_cmpeq_epi32(a, b); }
+	static INLINE uint32 Bits(__m128i m) { return _mm_movemask_ps(_mm_castsi128_ps(m)); }
+};
+
+template<int S> static void FilterSSE2(const uint8 *cur, const uint8 *prev, int op, bool specific, uint32 value)
+{
+	typedef RamSearchSSE2<S> V;
+	const uint32 laneMask = (1u << V::lanes) - 1;
+	// sse2 only compares signed, so unsigned searches flip the sign bit instead
+	const __m128i flip = valueSigned ? _mm_setzero_si128() : V::Splat(1u << (S * 8 - 1));
+	const __m128i konst = V::Splat(value);
+	// LESSEQUAL, GREATEREQUAL and NOTEQUAL are the complements of GREATER, LESS and EQUAL
+	const bool invert = op == FCEU_RS_LESSEQUAL || op == FCEU_RS_GREATEREQUAL || op == FCEU_RS_NOTEQUAL;
+
+	for (size_t w = 0; w < candidates.size(); w++)
+	{
+		uint64 c = candidates[w];
+		if (!c)
+			continue;
+		uint64 keep = 0;
+		for (int j = 0; j < 64; j += V::lanes)
+		{
+			size_t ofs = w * 64 + j;
+			__m128i a = V::LoadValues(cur + ofs);
+			__m128i b = specific ? konst : V::LoadValues(prev + ofs);
+			__m128i m;
+			if (op == FCEU_RS_DIFFERENTBY)
+				m = V::Eq(V::Sub(a, V::LoadValues(prev + ofs)), konst);
+			else
+			{
+				a = _mm_xor_si128(a, flip);
+				b = _mm_xor_si128(b, flip);
+				switch (op)
+				{
+				case FCEU_RS_LESS: case FCEU_RS_GREATEREQUAL: m = V::Gt(b, a); break;
+				case FCEU_RS_GREATER: case FCEU_RS_LESSEQUAL: m = V::Gt(a, b); break;
+				default: m = V::Eq(a, b); break;
+				}
+			}
+			uint32 bits = V::Bits(m);
+			if (invert)
+				bits = ~bits & laneMask;
+			keep |= (uint64)bits << j;
+		}
+		candidates[w] = c & keep;
+	}
+}
+
+#define FilterValues FilterSSE2
+#else
+#define FilterValues FilterScalar
+#endif
+
+// the regions point into the cartridge's memory, so they must not outlive the game
+void FCEU_RamSearchClose(void)
+{
+	regions.clear();
+	candidates.clear();
+	for (int i = 0; i < 2; i++)
+		snapshots[i].clear();
+	total = 0;
+	previous = 0;
+}
+
+int32 FCEUI_RamSearchReset(int size, bool sign)
+{
+	if (size != 1 && size != 2 && size != 4)
+		return -1;
+
+	valueSize = size;
+	valueSigned = sign;
+	regions.clear();
+	total = 0;
+
+	// coalesce the 1KB cheat blocks into runs that are contiguous both in the
+	// cpu address space and in host memory
+	for (uint32 a = 0; a < 0x10000; a += 0x400)
+	{
+		uint8 *mem = FCEU_CheatGetRAMBlock(a);
+		if (!mem)
+			continue;
+		if (!regions.empty())
+		{
+			RamSearchRegion &r = regions.back();
+			if (r.addr + r.size == a && r.mem + r.size == mem)
+			{
+				r.size += 0x400;
+				total += 0x400;
+				continue;
+			}
+		}
+		RamSearchRegion r = { a, total, 0x400, mem };
+		regions.push_back(r);
+		total += 0x400;
+	}
+
+	size_t words = (total + 63) / 64;
+	candidates.assign(words, ~(uint64)0);
+	for (int i = 0; i < 2; i++)
+		snapshots[i].assign(words * 64 + RS_PAD, 0);
+	if (total & 63)
+		candidates[words - 1] = ((uint64)1 << (total & 63)) - 1;
+
+	// a value may not straddle two regions
+	for (size_t i = 0; i < regions.size(); i++)
+		for (uint32 ofs = regions[i].ofs + regions[i].size - (size - 1); ofs < regions[i].ofs + regions[i].size; ofs++)
+			candidates[ofs >> 6] &= ~((uint64)1 << (ofs & 63));
+
+	previous = 0;
+	if (total)
+		TakeSnapshot(&snapshots[previous][0]);
+	return FCEUI_RamSearchGetCount();
+}
+
+int32 FCEUI_RamSearchFilter(int op, bool specific, int32 value)
+{
+	if (!total || op < FCEU_RS_LESS || op > FCEU_RS_DIFFERENTBY)
+		return 0;
+
+	uint8 *cur = &snapshots[previous ^ 1][0];
+	const uint8 *prev = &snapshots[previous][0];
+	TakeSnapshot(cur);
+
+	switch (valueSize)
+	{
+	case 1: FilterValues<1>(cur, prev, op, specific, (uint32)value); break;
+	case 2: FilterValues<2>(cur, prev, op, specific, (uint32)value); break;
+	case 4: FilterValues<4>(cur, prev, op, specific, (uint32)value); break;
+	}
+
+	// the values compared against become the "previous" values of the next pass
+	previous ^= 1;
+	return FCEUI_RamSearchGetCount();
+}
+
+int32 FCEUI_RamSearchGetCount(void)
+{
+	int32 count = 0;
+	for (size_t w = 0; w < candidates.size(); w++)
+		count += PopCount(candidates[w]);
+	return count;
+}
+
+void FCEUI_RamSearchGet(int (*callb)(uint32 a, int64 last, int64 current, void *data), void *data)
+{
+	size_t r = 0;
+	const uint8 *prev = total ? &snapshots[previous][0] : 0;
+
+	for (size_t w = 0; w < candidates.size(); w++)
+	{
+		uint64 c = candidates[w];
+		for (int j = 0; c; j++, c >>= 1)
+		{
+			if (!(c & 1))
+				continue;
+			uint32 ofs = (uint32)w * 64 + j;
+			while (ofs >= regions[r].ofs + regions[r].size)
+				r++;
+			const RamSearchRegion &reg = regions[r];
+			int64 last = RawToValue(ReadRaw(prev + ofs, valueSize), valueSize, valueSigned);
+			int64 current = RawToValue(ReadRaw(reg.mem + (ofs - reg.ofs), valueSize), valueSize, valueSigned);
+			if (!callb(reg.addr + (ofs - reg.ofs), last, current, data))
+				return;
+		}
+	}
+}
+
+void FCEUI_RamSearchExclude(uint32 a)
+{
+	for (size_t i = 0; i < regions.size(); i++)
+	{
+		if (a >= regions[i].addr && a < regions[i].addr + regions[i].size)
+		{
+			uint32 ofs = regions[i].ofs + (a - regions[i].addr);
+			candidates[ofs >> 6] &= ~((uint64)1 << (ofs & 63));
+			return;
+		}
+	}
+}
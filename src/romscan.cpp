@@ -0,0 +1,491 @@
+// ROM-set scanner. Walks a directory tree (looking inside zip and gz archives),
+// hashes every candidate image on a pool of worker threads and keeps the results
+// in a plain-text index keyed by path, size and modification time, so a rescan
+// only re-hashes what actually changed. iNES images get the same CRC32/MD5 the
+// loader reports for them; anything else is hashed as a whole file.
+//
+// Index lines are tab separated:
+//   size  mtime  crc32  md5  type  mapper  path  member
+// where member is the file inside an archive (empty for plain files). A file that
+// yields no roms at all (an archive of readmes, say) still gets one line, with type
+// "none" and zeroed hashes, so the next scan can skip it too.
+
+#include "types.h"
+#include "fceu.h"
+#include "cart.h"
+#include "ines.h"
+#include "driver.h"
+#include "utils/crc32.h"
+#include "utils/md5.h"
+#include "utils/xstring.h"
+#ifdef _SYSTEM_MINIZIP
+#include <minizip/unzip.h>
+#else
+#include "utils/unzip.h"
+#endif
+
+#include <zlib.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include <map>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+
+// nothing legitimate is bigger than a maxed out NES 2.0 image
+#define ROMSCAN_MAXSIZE (72 * 1024 * 1024)
+
+struct ROMIndexEntry
+{
+	uint64 size;
+	int64 mtime;
+	uint32 crc32;
+	uint8 md5[16];
+	std::string type;
+	int mapper;
+	std::string path;
+	std::string member;
+};
+
+struct ROMScanItem
+{
+	std::string path;
+	uint64 size;
+	int64 mtime;
+	std::vector<ROMIndexEntry> entries;
+};
+
+static const char *romExtensions[] = { ".nes", ".fds", ".nsf", ".unf", ".unif", ".nez", NULL };
+
+static bool HasExtension(const std::string &name, const char *ext)
+{
+	size_t len = strlen(ext);
+	if (name.size() < len)
+		return false;
+	for (size_t i = 0; i < len; i++)
+		if (tolower((unsigned char)name[name.size() - len + i]) != ext[i])
+			return false;
+	return true;
+}
+
+static bool IsROMName(const std::string &name)
+{
+	for (int i = 0; romExtensions[i]; i++)
+		if (HasExtension(name, romExtensions[i]))
+			return true;
+	return false;
+}
+
+static bool IsScannable(const std::string &name)
+{
+	return IsROMName(name) || HasExtension(name, ".zip") || HasExtension(name, ".gz");
+}
+
+// paths are utf-8 throughout; windows needs them widened before they reach the crt
+static bool StatPath(const std::string &path, uint64 *size, int64 *mtime, bool *isdir)
+{
+#ifdef WIN32
+	struct _stat64 st;
+	if (_wstat64(mbstowcs(path).c_str(), &st))
+		return false;
+#else
+	struct stat st;
+	if (stat(path.c_str(), &st))
+		return false;
+#endif
+	*size = st.st_size;
+	*mtime = st.st_mtime;
+	*isdir = (st.st_mode & S_IFMT) == S_IFDIR;
+	return true;
+}
+
+static voidpf ZCALLBACK ZipOpenUTF8(voidpf opaque, const char *filename, int mode)
+{
+	return FCEUD_UTF8fopen(filename, "rb");
+}
+
+static void ListFiles(const std::string &dir, std::vector<ROMScanItem> &out)
+{
+#ifdef WIN32
+	WIN32_FIND_DATAW wfd;
+	HANDLE hFind = FindFirstFileW(mbstowcs(dir + PSS "*").c_str(), &wfd);
+	if (hFind == INVALID_HANDLE_VALUE)
+		return;
+	do
+	{
+		std::string utf8name = wcstombs(wfd.cFileName);
+		const char *name = utf8name.c_str();
+#else
+	DIR *d = opendir(dir.c_str());
+	if (!d)
+		return;
+	struct dirent *ent;
+	while ((ent = readdir(d)) != NULL)
+	{
+		const char *name = ent->d_name;
+#endif
+		if (!strcmp(name, ".") || !strcmp(name, ".."))
+			continue;
+
+		std::string path = dir + PSS + name;
+		ROMScanItem item;
+		bool isdir;
+		if (!StatPath(path, &item.size, &item.mtime, &isdir))
+			continue;
+
+		if (isdir)
+			ListFiles(path, out);
+		else if (IsScannable(path) && item.size <= ROMSCAN_MAXSIZE)
+		{
+			item.path = path;
+			out.push_back(item);
+		}
+#ifdef WIN32
+	} while (FindNextFileW(hFind, &wfd));
+	FindClose(hFind);
+#else
+	}
+	closedir(d);
+#endif
+}
+
+static void HashImage(const uint8 *data, uint32 size, ROMIndexEntry &e)
+{
+	int mapper = iNESHashImage(data, size, &e.crc32, e.md5);
+	if (mapper >= 0)
+	{
+		e.type = "nes";
+		e.mapper = mapper;
+		return;
+	}
+
+	e.mapper = -1;
+	if (size >= 4 && !memcmp(data, "UNIF", 4))
+		e.type = "unif";
+	else if (size >= 5 && !memcmp(data, "NESM\x1a", 5))
+		e.type = "nsf";
+	else if ((size >= 4 && !memcmp(data, "FDS\x1a", 4)) || (size >= 15 && !memcmp(data + 1, "*NINTENDO-HVC*", 14)))
+		e.type = "fds";
+	else
+		e.type = "other";
+
+	md5_context md5;
+	md5_starts(&md5);
+	md5_update(&md5, (uint8*)data, size);
+	md5_finish(&md5, e.md5);
+	e.crc32 = CalcCRC32(0, (uint8*)data, size);
+}
+
+static void ScanZip(ROMScanItem &item)
+{
+	zlib_filefunc_def ffunc;
+	fill_fopen_filefunc(&ffunc);
+	ffunc.zopen_file = ZipOpenUTF8;
+	unzFile tz = unzOpen2(item.path.c_str(), &ffunc);
+	if (!tz)
+		return;
+
+	std::vector<uint8> buf;
+	for (int r = unzGoToFirstFile(tz); r == UNZ_OK; r = unzGoToNextFile(tz))
+	{
+		char name[512];
+		unz_file_info ufo;
+		if (unzGetCurrentFileInfo(tz, &ufo, name, sizeof(name), 0, 0, 0, 0) != UNZ_OK)
+			continue;
+		if (!IsROMName(name) || ufo.uncompressed_size > ROMSCAN_MAXSIZE)
+			continue;
+		if (unzOpenCurrentFile(tz) != UNZ_OK)
+			continue;
+
+		buf.resize(ufo.uncompressed_size + 1);
+		int got = unzReadCurrentFile(tz, &buf[0], ufo.uncompressed_size);
+		unzCloseCurrentFile(tz);
+		if (got != (int)ufo.uncompressed_size)
+			continue;
+
+		ROMIndexEntry e;
+		e.member = name;
+		HashImage(&buf[0], got, e);
+		item.entries.push_back(e);
+	}
+	unzClose(tz);
+}
+
+static bool ReadPlain(const std::string &path, std::vector<uint8> &buf, uint64 size)
+{
+	FILE *fp = FCEUD_UTF8fopen(path.c_str(), "rb");
+	if (!fp)
+		return false;
+	buf.resize(size + 1);
+	size_t got = fread(&buf[0], 1, size, fp);
+	fclose(fp);
+	buf.resize(got);
+	return got == size;
+}
+
+// gzopen only takes a narrow path, so the file is read through the utf-8 helper and
+// inflated in memory instead; concatenated members are joined the way gzread would
+static bool ReadGz(const std::string &path, std::vector<uint8> &buf, uint64 size)
+{
+	std::vector<uint8> packed;
+	if (!ReadPlain(path, packed, size) || packed.empty())
+		return false;
+
+	z_stream zs;
+	memset(&zs, 0, sizeof(zs));
+	if (inflateInit2(&zs, 16 + MAX_WBITS) != Z_OK)
+		return false;
+	zs.next_in = &packed[0];
+	zs.avail_in = packed.size();
+
+	buf.clear();
+	uint8 chunk[65536];
+	int r;
+	do
+	{
+		zs.next_out = chunk;
+		zs.avail_out = sizeof(chunk);
+		r = inflate(&zs, Z_NO_FLUSH);
+		buf.insert(buf.end(), chunk, chunk + (sizeof(chunk) - zs.avail_out));
+		if (r == Z_STREAM_END && zs.avail_in)
+			r = inflateReset(&zs);
+	} while (r == Z_OK && buf.size() <= ROMSCAN_MAXSIZE);
+	inflateEnd(&zs);
+	return r == Z_STREAM_END;
+}
+
+static void ScanItem(ROMScanItem &item)
+{
+	if (HasExtension(item.path, ".zip"))
+	{
+		ScanZip(item);
+		return;
+	}
+
+	std::vector<uint8> buf;
+	bool ok = HasExtension(item.path, ".gz") ? ReadGz(item.path, buf, item.size) : ReadPlain(item.path, buf, item.size);
+	if (!ok || buf.empty())
+		return;
+
+	ROMIndexEntry e;
+	HashImage(&buf[0], buf.size(), e);
+	item.entries.push_back(e);
+}
+
+static void HexToBytes(const char *hex, uint8 *out, int len)
+{
+	for (int i = 0; i < len; i++)
+	{
+		unsigned int v = 0;
+		sscanf(hex + i * 2, "%2x", &v);
+		out[i] = v;
+	}
+}
+
+static bool LoadIndex(const char *indexFile, std::vector<ROMIndexEntry> &out)
+{
+	FILE *fp = FCEUD_UTF8fopen(indexFile, "rb");
+	if (!fp)
+		return false;
+
+	char line[4096];
+	while (fgets(line, sizeof(line), fp))
+	{
+		if (line[0] == '#')
+			continue;
+		line[strcspn(line, "\r\n")] = 0;
+
+		// split on tabs; path and member may contain spaces
+		std::vector<char*> f;
+		char *p = line;
+		f.push_back(p);
+		while ((p = strchr(p, '\t')) != NULL)
+		{
+			*p++ = 0;
+			f.push_back(p);
+		}
+		if (f.size() != 8 || strlen(f[3]) != 32)
+			continue;
+
+		ROMIndexEntry e;
+		e.size = strtoull(f[0], 0, 10);
+		e.mtime = strtoll(f[1], 0, 10);
+		e.crc32 = strtoul(f[2], 0, 16);
+		HexToBytes(f[3], e.md5, 16);
+		e.type = f[4];
+		e.mapper = atoi(f[5]);
+		e.path = f[6];
+		e.member = f[7];
+		out.push_back(e);
+	}
+	fclose(fp);
+	return true;
+}
+
+static bool SaveIndex(const char *indexFile, const std::vector<ROMScanItem> &items)
+{
+	// write next to the real index and swap it in, so an interrupted scan can't truncate it
+	std::string tmp = std::string(indexFile) + ".tmp";
+	FILE *fp = FCEUD_UTF8fopen(tmp.c_str(), "wb");
+	if (!fp)
+		return false;
+
+	fprintf(fp, "# fceux rom index: size mtime crc32 md5 type mapper path member\n");
+	for (size_t i = 0; i < items.size(); i++)
+	{
+		if (items[i].entries.empty())
+			fprintf(fp, "%llu\t%lld\t%08x\t%032x\tnone\t-1\t%s\t\n", (unsigned long long)items[i].size, (long long)items[i].mtime, 0, 0, items[i].path.c_str());
+		for (size_t j = 0; j < items[i].entries.size(); j++)
+		{
+			const ROMIndexEntry &e = items[i].entries[j];
+			fprintf(fp, "%llu\t%lld\t%08x\t", (unsigned long long)items[i].size, (long long)items[i].mtime, e.crc32);
+			for (int x = 0; x < 16; x++)
+				fprintf(fp, "%02x", e.md5[x]);
+			fprintf(fp, "\t%s\t%d\t%s\t%s\n", e.type.c_str(), e.mapper, items[i].path.c_str(), e.member.c_str());
+		}
+	}
+
+	bool ok = !ferror(fp);
+	ok &= fclose(fp) == 0;
+#ifdef WIN32
+	std::wstring wtmp = mbstowcs(tmp), windex = mbstowcs((std::string)indexFile);
+	if (!ok)
+	{
+		_wremove(wtmp.c_str());
+		return false;
+	}
+	_wremove(windex.c_str());
+	return _wrename(wtmp.c_str(), windex.c_str()) == 0;
+#else
+	if (!ok)
+	{
+		remove(tmp.c_str());
+		return false;
+	}
+	return rename(tmp.c_str(), indexFile) == 0;
+#endif
+}
+
+// FCEUI_LookupROMIndex answers from this, first rom per path, until the index file is
+// rewritten (by a scan here or by another process) or a different one is asked for
+static std::mutex lookupMutex;
+static std::string lookupIndexFile;
+static bool lookupLoaded = false;
+static uint64 lookupIndexSize;
+static int64 lookupIndexMtime;
+static std::map<std::string, ROMIndexEntry> lookupEntries;
+
+int FCEUI_ScanROMs(const char *dir, const char *indexFile, int threads, int *hashed)
+{
+	std::vector<ROMScanItem> items;
+	std::string root = dir;
+	while (root.size() > 1 && (root[root.size() - 1] == '/' || root[root.size() - 1] == '\\'))
+		root.erase(root.size() - 1);
+	ListFiles(root, items);
+	std::sort(items.begin(), items.end(), [](const ROMScanItem &a, const ROMScanItem &b) { return a.path < b.path; });
+
+	// anything whose size and mtime still match the old index keeps its hashes
+	std::vector<ROMIndexEntry> old;
+	LoadIndex(indexFile, old);
+	std::multimap<std::string, const ROMIndexEntry*> byPath;
+	for (size_t i = 0; i < old.size(); i++)
+		byPath.insert(std::make_pair(old[i].path, &old[i]));
+
+	std::vector<size_t> todo;
+	for (size_t i = 0; i < items.size(); i++)
+	{
+		ROMScanItem &item = items[i];
+		auto range = byPath.equal_range(item.path);
+		bool match = range.first != range.second;
+		for (auto it = range.first; it != range.second; ++it)
+			match &= it->second->size == item.size && it->second->mtime == item.mtime;
+		if (match)
+		{
+			for (auto it = range.first; it != range.second; ++it)
+				if (it->second->type != "none")
+					item.entries.push_back(*it->second);
+		}
+		else
+			todo.push_back(i);
+	}
+
+	if (threads < 1)
+		threads = std::max(1u, std::thread::hardware_concurrency());
+	threads = std::min<int>(threads, std::max<size_t>(todo.size(), 1));
+
+	std::atomic<size_t> next(0);
+	auto worker = [&]() {
+		size_t n;
+		while ((n = next++) < todo.size())
+			ScanItem(items[todo[n]]);
+	};
+	std::vector<std::thread> pool;
+	for (int i = 1; i < threads; i++)
+		pool.push_back(std::thread(worker));
+	worker();
+	for (size_t i = 0; i < pool.size(); i++)
+		pool[i].join();
+
+	if (hashed)
+		*hashed = todo.size();
+
+	{
+		std::lock_guard<std::mutex> lock(lookupMutex);
+		lookupLoaded = false;
+	}
+	if (!SaveIndex(indexFile, items))
+		return -1;
+
+	int count = 0;
+	for (size_t i = 0; i < items.size(); i++)
+		count += items[i].entries.size();
+	return count;
+}
+
+bool FCEUI_LookupROMIndex(const char *indexFile, const char *path, uint32 *crc32, uint8 md5[16])
+{
+	uint64 size, indexSize = 0;
+	int64 mtime, indexMtime = 0;
+	bool isdir;
+	StatPath(indexFile, &indexSize, &indexMtime, &isdir);
+
+	std::lock_guard<std::mutex> lock(lookupMutex);
+	if (!lookupLoaded || lookupIndexFile != indexFile || lookupIndexSize != indexSize || lookupIndexMtime != indexMtime)
+	{
+		std::vector<ROMIndexEntry> entries;
+		LoadIndex(indexFile, entries);
+		lookupEntries.clear();
+		// an archive answers with its first rom, the same one the loader would pick
+		for (size_t i = 0; i < entries.size(); i++)
+			if (entries[i].type != "none")
+				lookupEntries.insert(std::make_pair(entries[i].path, entries[i]));
+		lookupIndexFile = indexFile;
+		lookupIndexSize = indexSize;
+		lookupIndexMtime = indexMtime;
+		lookupLoaded = true;
+	}
+
+	std::map<std::string, ROMIndexEntry>::const_iterator it = lookupEntries.find(path);
+	if (it == lookupEntries.end())
+		return false;
+
+	const ROMIndexEntry &e = it->second;
+	if (!StatPath(path, &size, &mtime, &isdir) || e.size != size || e.mtime != mtime)
+		return false;
+
+	*crc32 = e.crc32;
+	memcpy(md5, e.md5, 16);
+	return true;
+}
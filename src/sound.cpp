@@ -27,6 +27,7 @@
 #include "state.h"
 #include "wave.h"
 #include "debug.h"
+#include "cdl.h"
 
 #include <cstdlib>
 #include <cstdio>
@@ -84,6 +85,14 @@ uint32 soundtsi=0;
 static int32 sqacc[2];
 /* LQ variables segment ends. */
 
+/* Variables exclusively for high-quality sound.  These are the levels last
+   handed to the band-limited buffer.
+*/
+static int32 sqmix=0;		// wlookup1[] output of the squares
+static int32 tndmix=0;		// wlookup2[] output of triangle, noise and PCM
+static int32 explevel=0;	// Expansion sound output from WaveHi[]
+/* HQ variables segment ends. */
+
 /*static*/ int32 lengthcount[4];
 static const uint8 lengthtable[0x20]=
 {
@@ -170,6 +179,7 @@ static void PrepDPCM()
  #ifdef WIN32
  if(debug_loggingCD)LogDPCM(0x8000+DMCAddress, DMCSize);
  #endif
+ if(cdl_enabled)FCEU_CDLogDPCM(0x8000+DMCAddress, DMCSize);
 
 }
 
@@ -579,83 +589,111 @@ void FCEU_SoundCPUHook(int cycles)
  }
 }
 
-void RDoPCM(void)
+static INLINE void SetSQMix(uint32 ts, int32 out)
 {
- uint32 V; //mbg merge 7/17/06 made uint32
+ int32 v=wlookup1[out];
 
- for(V=ChannelBC[4];V<SOUNDTS;V++)
-  WaveHi[V]+=(((RawDALatch<<16)/256) * FSettings.PCMVolume)&(~0xFFFF); // TODO get rid of floating calculations to binary. set log volume scaling.
- ChannelBC[4]=SOUNDTS;
+ if(v!=sqmix)
+ {
+  BandLimitedStep(ts,v-sqmix);
+  sqmix=v;
+ }
+}
+
+static INLINE void SetTNDMix(uint32 ts, int32 out)
+{
+ int32 v;
+
+ if(out>202) out=202;
+ v=wlookup2[out];
+ if(v!=tndmix)
+ {
+  BandLimitedStep(ts,v-tndmix);
+  tndmix=v;
+ }
 }
 
 /* This has the correct phase.  Don't mess with it. */
-static INLINE void RDoSQ(int x)		//Int x decides if this is Square Wave 1 or 2
+/* Both squares go through one nonlinear mixer, so they are always rendered
+   together and their steps are handed to the band-limited buffer in order.
+   Only the cycles where a duty counter moves are visited.
+*/
+static void RDoSQ(void)
 {
-   int32 V;
-   int32 amp, ampx;
-   int32 rthresh;
-   int32 *D;
-   int32 currdc;
-   int32 cf;
-   int32 rc;
-
-   if(curfreq[x]<8 || curfreq[x]>0x7ff)
-    goto endit;
-   if(!CheckFreq(curfreq[x],PSG[(x<<2)|0x1]))
-    goto endit;
-   if(!lengthcount[x])
-    goto endit;
-
-   if(EnvUnits[x].Mode&0x1)
-    amp=EnvUnits[x].Speed;
-   else
-    amp=EnvUnits[x].decvolume;	//Set the volume of the Square Wave
+   int32 amp[2], ampx;
+   int32 rthresh[2];
+   int32 currdc[2];
+   int32 cf[2];
+   int32 rc[2];
+   int run[2];
+   uint32 pos,end;
+   int x;
 
-   //Modify Square wave volume based on channel volume modifiers
-   //adelikat: Note: the formulat x = x * y /100 does not yield exact results, but is "close enough" and avoids the need for using double vales or implicit cohersion which are slower (we need speed here)
-   ampx = x ? FSettings.Square2Volume : FSettings.Square1Volume; // TODO OPTIMIZE ME!
-   if (ampx != 256) amp = (amp * ampx) / 256; // CaH4e3: fixed - setting up maximum volume for square2 caused complete mute square2 channel
+   pos=ChannelBC[0];
+   end=SOUNDTS;
+   if(end<pos) end=pos;
 
-   amp<<=24;
+   for(x=0;x<2;x++)
+   {
+    run[x]=1;
+    if(curfreq[x]<8 || curfreq[x]>0x7ff)
+     run[x]=0;
+    if(!CheckFreq(curfreq[x],PSG[(x<<2)|0x1]))
+     run[x]=0;
+    if(!lengthcount[x])
+     run[x]=0;
 
-   rthresh=RectDuties[(PSG[(x<<2)]&0xC0)>>6];
+    if(EnvUnits[x].Mode&0x1)
+     amp[x]=EnvUnits[x].Speed;
+    else
+     amp[x]=EnvUnits[x].decvolume;	//Set the volume of the Square Wave
 
-   D=&WaveHi[ChannelBC[x]];
-   V=SOUNDTS-ChannelBC[x];
+    //Modify Square wave volume based on channel volume modifiers
+    //adelikat: Note: the formulat x = x * y /100 does not yield exact results, but is "close enough" and avoids the need for using double vales or implicit cohersion which are slower (we need speed here)
+    ampx = x ? FSettings.Square2Volume : FSettings.Square1Volume; // TODO OPTIMIZE ME!
+    if (ampx != 256) amp[x] = (amp[x] * ampx) / 256; // CaH4e3: fixed - setting up maximum volume for square2 caused complete mute square2 channel
 
-   currdc=RectDutyCount[x];
-   cf=(curfreq[x]+1)*2;
-   rc=wlcount[x];
+    if(!run[x]) amp[x]=0;
 
-   while(V>0)
-   {
-    if(currdc<rthresh)
-     *D+=amp;
-    rc--;
-    if(!rc)
-    {
-     rc=cf;
-     currdc=(currdc+1)&7;
-    }
-    V--;
-    D++;
+    rthresh[x]=RectDuties[(PSG[(x<<2)]&0xC0)>>6];
+    currdc[x]=RectDutyCount[x];
+    cf[x]=(curfreq[x]+1)*2;
+    rc[x]=wlcount[x];
+    if(rc[x]<=0) rc[x]=cf[x];
    }
 
-   RectDutyCount[x]=currdc;
-   wlcount[x]=rc;
+   SetSQMix(pos,(currdc[0]<rthresh[0]?amp[0]:0)+(currdc[1]<rthresh[1]?amp[1]:0));
 
-   endit:
-   ChannelBC[x]=SOUNDTS;
-}
+   if(run[0] || run[1])
+    for(;;)
+    {
+     int32 step=run[0]?rc[0]:0x7FFFFFFF;
+
+     if(run[1] && rc[1]<step) step=rc[1];
+     if((uint32)step>end-pos) break;
+     pos+=step;
+
+     for(x=0;x<2;x++)
+      if(run[x])
+      {
+       rc[x]-=step;
+       if(!rc[x])
+       {
+        rc[x]=cf[x];
+        currdc[x]=(currdc[x]+1)&7;
+       }
+      }
+     SetSQMix(pos,(currdc[0]<rthresh[0]?amp[0]:0)+(currdc[1]<rthresh[1]?amp[1]:0));
+    }
 
-static void RDoSQ1(void)
-{
- RDoSQ(0);
-}
+   for(x=0;x<2;x++)
+    if(run[x])
+    {
+     RectDutyCount[x]=currdc[x];
+     wlcount[x]=rc[x]-(end-pos);
+    }
 
-static void RDoSQ2(void)
-{
- RDoSQ(1);
+   ChannelBC[0]=ChannelBC[1]=end;
 }
 
 static void RDoSQLQ(void)
@@ -756,46 +794,97 @@ static void RDoSQLQ(void)
    }
 }
 
-static void RDoTriangle(void)
+/* Triangle, noise and PCM share the second mixer and are rendered together
+   for the same reason as the squares.
+*/
+static void RDoTriangleNoisePCM(void)
 {
- uint32 V; //mbg merge 7/17/06 made uitn32
- int32 tcout;
-
+ int32 tcout,tout,nout,pout;
+ int32 tfreq,nfreq;
+ int32 trc,nrc;
+ int32 namp;
+ int trun,nshift;
+ uint32 pos,end;
+
+ pos=ChannelBC[2];
+ end=SOUNDTS;
+ if(end<pos) end=pos;
+
+ //Modify volume based on channel volume modifiers
  tcout=(tristep&0xF);
  if(!(tristep&0x10)) tcout^=0xF;
- tcout=(tcout*3) << 16;  //(tcout<<1);
+ tout=(tcout*3*FSettings.TriangleVolume)>>8;
+ tfreq=(PSG[0xa]|((PSG[0xb]&7)<<8))+1;
+ trun=lengthcount[2] && TriCount;	/* When halted, the counter still outputs its last step. */
+ trc=wlcount[2];
+ if(trc<=0) trc=tfreq;
 
- if(!lengthcount[2] || !TriCount)
- {           /* Counter is halted, but we still need to output. */
-  /*int32 *start = &WaveHi[ChannelBC[2]];
-  int32 count = SOUNDTS - ChannelBC[2];
-  while(count--)
-  {
-   //Modify volume based on channel volume modifiers
-   *start += (tcout/256*FSettings.TriangleVolume)&(~0xFFFF);  // TODO OPTIMIZE ME NOW DAMMIT!
-   start++;
-  }*/
-  int32 cout = (tcout/256*FSettings.TriangleVolume)&(~0xFFFF);
-  for(V=ChannelBC[2];V<SOUNDTS;V++)
-   WaveHi[V]+=cout;
- }
+ if(EnvUnits[2].Mode&0x1)
+  namp=EnvUnits[2].Speed;
+ else
+  namp=EnvUnits[2].decvolume;
+
+ //Modfiy Noise channel volume based on channel volume setting
+ //adelikat: Note: the formulat x = x * y /100 does not yield exact results, but is "close enough" and avoids the need for using double vales or implicit cohersion which are slower (we need speed here)
+ if (FSettings.NoiseVolume != 256) namp = (namp * FSettings.NoiseVolume) / 256;  // TODO OPTIMIZE ME!
+ namp<<=1;
+ if(!lengthcount[3])
+  namp=0;
+ nout=((nreg>>0xe)&1)?0:namp;
+ if(PAL)
+  nfreq=NoiseFreqTablePAL[PSG[0xE]&0xF];
+ else
+  nfreq=NoiseFreqTableNTSC[PSG[0xE]&0xF];
+ if(PSG[0xE]&0x80)  // "short" noise
+  nshift=8;
  else
-  for(V=ChannelBC[2];V<SOUNDTS;V++)
+  nshift=13;
+ nrc=wlcount[3];
+ if(nrc<=0) nrc=nfreq;
+
+ pout=(RawDALatch*FSettings.PCMVolume)>>8;
+
+ SetTNDMix(pos,tout+nout+pout);
+
+ for(;;)
+ {
+  int32 step=nrc;
+
+  if(trun && trc<step) step=trc;
+  if((uint32)step>end-pos) break;
+  pos+=step;
+
+  if(trun)
   {
-    //Modify volume based on channel volume modifiers
-	WaveHi[V]+=(tcout/256*FSettings.TriangleVolume)&(~0xFFFF);  // TODO OPTIMIZE ME!
-    wlcount[2]--;
-    if(!wlcount[2])
-    {
-     wlcount[2]=(PSG[0xa]|((PSG[0xb]&7)<<8))+1;
-     tristep++;
-     tcout=(tristep&0xF);
-     if(!(tristep&0x10)) tcout^=0xF;
-     tcout=(tcout*3) << 16;
-    }
+   trc-=step;
+   if(!trc)
+   {
+    trc=tfreq;
+    tristep++;
+    tcout=(tristep&0xF);
+    if(!(tristep&0x10)) tcout^=0xF;
+    tout=(tcout*3*FSettings.TriangleVolume)>>8;
+   }
+  }
+
+  nrc-=step;
+  if(!nrc)
+  {
+   uint8 feedback;
+   nrc=nfreq;
+   feedback=((nreg>>nshift)&1)^((nreg>>14)&1);
+   nreg=(nreg<<1)+feedback;
+   nreg&=0x7fff;
+   nout=((nreg>>0xe)&1)?0:namp;
   }
+  SetTNDMix(pos,tout+nout+pout);
+ }
+
+ if(trun)
+  wlcount[2]=trc-(end-pos);
+ wlcount[3]=nrc-(end-pos);
 
- ChannelBC[2]=SOUNDTS;
+ ChannelBC[2]=ChannelBC[3]=ChannelBC[4]=end;
 }
 
 static void RDoTriangleNoisePCMLQ(void)
@@ -942,71 +1031,6 @@ static void RDoTriangleNoisePCMLQ(void)
 }
 
 
-static void RDoNoise(void)
-{
- uint32 V; //mbg merge 7/17/06 made uint32
- int32 outo;
- uint32 amptab[2];
-
- if(EnvUnits[2].Mode&0x1)
-  amptab[0]=EnvUnits[2].Speed;
- else
-  amptab[0]=EnvUnits[2].decvolume;
-
- //Modfiy Noise channel volume based on channel volume setting
- //adelikat: Note: the formulat x = x * y /100 does not yield exact results, but is "close enough" and avoids the need for using double vales or implicit cohersion which are slower (we need speed here)
- if (FSettings.NoiseVolume != 256) amptab[0] = (amptab[0] * FSettings.NoiseVolume) / 256;  // TODO OPTIMIZE ME!
- amptab[0]<<=16;
- amptab[1]=0;
-
- amptab[0]<<=1;
-
- outo=amptab[(nreg>>0xe)&1];
-
- if(!lengthcount[3])
- {
-  outo=amptab[0]=0;
- }
-
- if(PSG[0xE]&0x80)  // "short" noise
-  for(V=ChannelBC[3];V<SOUNDTS;V++)
-  {
-   WaveHi[V]+=outo;
-   wlcount[3]--;
-   if(!wlcount[3])
-   {
-    uint8 feedback;
-    if(PAL)
-      wlcount[3]=NoiseFreqTablePAL[PSG[0xE]&0xF];
-	else
-      wlcount[3]=NoiseFreqTableNTSC[PSG[0xE]&0xF];
-    feedback=((nreg>>8)&1)^((nreg>>14)&1);
-    nreg=(nreg<<1)+feedback;
-    nreg&=0x7fff;
-    outo=amptab[(nreg>>0xe)&1];
-   }
-  }
- else
-  for(V=ChannelBC[3];V<SOUNDTS;V++)
-  {
-   WaveHi[V]+=outo;
-   wlcount[3]--;
-   if(!wlcount[3])
-   {
-    uint8 feedback;
-    if(PAL)
-      wlcount[3]=NoiseFreqTablePAL[PSG[0xE]&0xF];
-	else
-      wlcount[3]=NoiseFreqTableNTSC[PSG[0xE]&0xF];
-    feedback=((nreg>>13)&1)^((nreg>>14)&1);
-    nreg=(nreg<<1)+feedback;
-    nreg&=0x7fff;
-    outo=amptab[(nreg>>0xe)&1];
-   }
-  }
- ChannelBC[3]=SOUNDTS;
-}
-
 DECLFW(Write_IRQFM)
 {
  V=(V&0xC0)>>6;
@@ -1053,21 +1077,23 @@ int FlushEmulateSound(void)
 
   if(FSettings.soundq>=1)
   {
-   int32 *tmpo=&WaveHi[soundtsoffs];
-
-   if(GameExpSound.HiFill) GameExpSound.HiFill();
-
-   for(x=soundtimestamp;x;x--)
+   /* Expansion sound is still rendered per cycle, but only its changes
+      are passed on. */
+   if(GameExpSound.HiFill)
    {
-    uint32 b=*tmpo;
-    *tmpo=(b&65535)+wlookup2[(b>>16)&255]+wlookup1[b>>24];
-    tmpo++;
-   }
-   end=NeoFilterSound(WaveHi,WaveFinal,SOUNDTS,&left);
+    GameExpSound.HiFill();
 
-   memmove(WaveHi,WaveHi+SOUNDTS-left,left*sizeof(uint32));
-   memset(WaveHi+left,0,sizeof(WaveHi)-left*sizeof(uint32));
+    for(x=0;x<(int)SOUNDTS;x++)
+     if(WaveHi[x]!=explevel)
+     {
+      BandLimitedStep(x,WaveHi[x]-explevel);
+      explevel=WaveHi[x];
+     }
+    memset(WaveHi,0,SOUNDTS*sizeof(int32));
+   }
+   end=BandLimitedSound(WaveFinal,SOUNDTS);
 
+   left=0;
    if(GameExpSound.HiSync) GameExpSound.HiSync(left);
    for(x=0;x<5;x++)
     ChannelBC[x]=left;
@@ -1206,6 +1232,8 @@ void FCEUSND_Power(void)
         for(x=0;x<5;x++)
          ChannelBC[x]=0;
         soundtsoffs=0;
+        BandLimitedReset();
+        sqmix=tndmix=explevel=0;
         LoadDMCPeriod(DMCFormat&0xF);
 }
 
@@ -1217,7 +1245,7 @@ void SetSoundVariables(void)
   fhinc=PAL?16626:14915;  // *2 CPU clock rate
   fhinc*=24;
 
-  if(FSettings.SndRate)
+  if(FSettings.SndRate && (!computeOnly || computeSound))
   {
    wlookup1[0]=0;
    for(x=1;x<32;x++)
@@ -1233,11 +1261,11 @@ void SetSoundVariables(void)
    }
    if(FSettings.soundq>=1)
    {
-    DoNoise=RDoNoise;
-    DoTriangle=RDoTriangle;
-    DoPCM=RDoPCM;
-    DoSQ1=RDoSQ1;
-    DoSQ2=RDoSQ2;
+    DoSQ1=RDoSQ;
+    DoSQ2=RDoSQ;
+    DoTriangle=RDoTriangleNoisePCM;
+    DoNoise=RDoTriangleNoisePCM;
+    DoPCM=RDoTriangleNoisePCM;
    }
    else
    {
@@ -1252,10 +1280,12 @@ void SetSoundVariables(void)
   else
   {
    DoNoise=DoTriangle=DoPCM=DoSQ1=DoSQ2=Dummyfunc;
+   memset(ChannelBC,0,sizeof(ChannelBC));
    return;
   }
 
   MakeFilters(FSettings.SndRate);
+  sqmix=tndmix=explevel=0;
 
   if(GameExpSound.RChange)
    GameExpSound.RChange();
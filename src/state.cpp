@@ -28,6 +28,7 @@
 #include "utils/endian.h"
 #include "utils/memory.h"
 #include "utils/xstring.h"
+#include "utils/crc32.h"
 #include "file.h"
 #include "fds.h"
 #include "state.h"
@@ -142,6 +143,11 @@ static int SubWrite(EMUFILE* os, SFORMAT *sf)
 			sf++;
 			continue;
 		}
+		if(sf->s&FCEUSTATE_LOADONLY)
+		{
+			sf++;
+			continue;
+		}
 
 		acc+=8;			//Description + size
 		acc+=sf->s&(~FCEUSTATE_FLAGS);
@@ -186,6 +192,156 @@ static int WriteStateChunk(EMUFILE* os, int type, SFORMAT *sf)
 	return (bsize+5);
 }
 
+static uint32 SubDigest(uint32 crc, SFORMAT *sf)
+{
+	while(sf->v)
+	{
+		if(sf->s==~0)		//Link to another struct
+		{
+			crc=SubDigest(crc,(SFORMAT *)sf->v);
+			sf++;
+			continue;
+		}
+		if(sf->s&FCEUSTATE_LOADONLY)
+		{
+			sf++;
+			continue;
+		}
+
+		uint32 size=sf->s&(~FCEUSTATE_FLAGS);
+		uint8 *p=(sf->s&FCEUSTATE_INDIRECT)?*(uint8 **)sf->v:(uint8 *)sf->v;
+
+		//hash values in savestate (little endian) order so digests compare across hosts
+#ifndef LSB_FIRST
+		if(sf->s&RLSB)
+			FlipByteOrder(p,size);
+#endif
+		crc=CalcCRC32(crc,p,size);
+#ifndef LSB_FIRST
+		if(sf->s&RLSB)
+			FlipByteOrder(p,size);
+#endif
+		sf++;
+	}
+	return crc;
+}
+
+void FCEUSS_Digest(uint32 digest[FCEUSS_DIGESTS])
+{
+	FCEUPPU_SaveState();
+	FCEUSND_SaveState();
+	digest[0]=SubDigest(SubDigest(0,SFCPU),SFCPUC);
+	digest[1]=SubDigest(SubDigest(0,FCEUPPU_STATEINFO),FCEU_NEWPPU_STATEINFO);
+	digest[2]=SubDigest(0,FCEUSND_STATEINFO);
+	if(SPreSave) SPreSave();
+	digest[3]=SubDigest(0,SFMDATA);
+	if(SPreSave) SPostSave();
+}
+
+//raw snapshot layout: every region of the SFORMAT tables in save order, flattened once.
+//the entries are kept rather than their pointers so FCEUSTATE_INDIRECT regions follow their targets.
+static std::vector<SFORMAT*> rawLayout;
+static size_t rawExStart;
+static uint32 rawSize;
+static bool rawLayoutValid=false;
+
+static void RawAddRegions(SFORMAT *sf)
+{
+	while(sf->v)
+	{
+		if(sf->s==~0)		//Link to another struct
+		{
+			RawAddRegions((SFORMAT *)sf->v);
+			sf++;
+			continue;
+		}
+		if((sf->s&(~FCEUSTATE_FLAGS)) && !(sf->s&FCEUSTATE_LOADONLY))
+		{
+			rawLayout.push_back(sf);
+			rawSize+=sf->s&(~FCEUSTATE_FLAGS);
+		}
+		sf++;
+	}
+}
+
+static void RawMakeLayout(void)
+{
+	if(rawLayoutValid) return;
+	rawLayout.clear();
+	rawSize=0;
+	RawAddRegions(SFCPU);
+	RawAddRegions(SFCPUC);
+	RawAddRegions(FCEUPPU_STATEINFO);
+	RawAddRegions(FCEU_NEWPPU_STATEINFO);
+	RawAddRegions(FCEUCTRL_STATEINFO);
+	RawAddRegions(FCEUSND_STATEINFO);
+	RawAddRegions(FCEUMOV_STATEINFO);
+	rawExStart=rawLayout.size();
+	RawAddRegions(SFMDATA);
+	rawLayoutValid=true;
+}
+
+static INLINE uint8 *RawRegionData(SFORMAT *sf)
+{
+	return (sf->s&FCEUSTATE_INDIRECT)?*(uint8 **)sf->v:(uint8 *)sf->v;
+}
+
+static uint8 *RawCopyOut(uint8 *buf, size_t first, size_t last)
+{
+	for(size_t i=first;i<last;i++)
+	{
+		uint32 len=rawLayout[i]->s&(~FCEUSTATE_FLAGS);
+		memcpy(buf,RawRegionData(rawLayout[i]),len);
+		buf+=len;
+	}
+	return buf;
+}
+
+uint32 FCEUSS_RawSize(void)
+{
+	RawMakeLayout();
+	return rawSize + (isFDS ? FDSDiskStateMaxSize() : 0);
+}
+
+bool FCEUSS_RawSave(uint8 *buf, uint32 size)
+{
+	if(size<FCEUSS_RawSize())
+		return false;
+
+	FCEUPPU_SaveState();
+	FCEUSND_SaveState();
+	buf=RawCopyOut(buf,0,rawExStart);
+	if(SPreSave) SPreSave();
+	buf=RawCopyOut(buf,rawExStart,rawLayout.size());
+	if(SPreSave) SPostSave();
+	if(isFDS)
+		FDSSaveDiskState(buf);
+	return true;
+}
+
+bool FCEUSS_RawLoad(const uint8 *buf, uint32 size)
+{
+	if(size!=FCEUSS_RawSize())
+		return false;
+	if(isFDS && !FDSLoadDiskState(buf+rawSize,size-rawSize))
+		return false;
+
+	for(size_t i=0;i<rawLayout.size();i++)
+	{
+		uint32 len=rawLayout[i]->s&(~FCEUSTATE_FLAGS);
+		memcpy(RawRegionData(rawLayout[i]),buf,len);
+		buf+=len;
+	}
+
+	extern int resetDMCacc;
+	resetDMCacc=0;
+	if(GameStateRestore)
+		GameStateRestore(FCEU_VERSION_NUMERIC);
+	FCEUPPU_LoadState(FCEU_VERSION_NUMERIC);
+	FCEUSND_LoadState(FCEU_VERSION_NUMERIC);
+	return true;
+}
+
 static SFORMAT *CheckS(SFORMAT *sf, uint32 tsize, char *desc)
 {
 	while(sf->v)
@@ -254,6 +410,8 @@ static bool ReadStateChunks(EMUFILE* is, int32 totalsize)
 
 	read_sfcpuc=0;
 	read_snd=0;
+	if(isFDS)
+		FDSBeginStateLoad();
 
 	//mbg 6/16/08 - wtf
 	//// int moo=X.mooPI;
@@ -284,6 +442,16 @@ static bool ReadStateChunks(EMUFILE* is, int32 totalsize)
 			if(!ReadStateChunk(is,SFMDATA,size)) 
 				ret=false; 
 			break;
+		case 0x11:
+			if(isFDS)
+			{
+				std::vector<uint8> disk(size+1);
+				if(is->fread((char*)&disk[0],size) != size || !FDSLoadDiskState(&disk[0],size))
+					ret=false;
+			}
+			else
+				is->fseek(size,SEEK_CUR);
+			break;
 
 			// now it gets hackier:
 		case 5:
@@ -414,6 +582,17 @@ bool FCEUSS_SaveMS(EMUFILE* outstream, int compressionLevel)
 	totalsize+=WriteStateChunk(os,0x10,SFMDATA);
 	if(SPreSave) SPostSave();
 
+	// save the changed blocks of the fds disk sides
+	if(isFDS)
+	{
+		std::vector<uint8> disk(FDSDiskStateSize());
+		uint32 size = FDSSaveDiskState(&disk[0]);
+		os->fputc(0x11);
+		write32le(size, os);
+		os->fwrite((char*)&disk[0],size);
+		totalsize += 5 + size;
+	}
+
 	//save the length of the file
 	int len = memory_savestate.size();
 
@@ -855,6 +1034,7 @@ void ResetExState(void (*PreSave)(void), void (*PostSave)(void))
 	SPreSave = PreSave;
 	SPostSave = PostSave;
 	SFEXINDEX=0;
+	rawLayoutValid=false;
 }
 
 void AddExState(void *v, uint32 s, int type, char *desc)
@@ -904,6 +1084,7 @@ void AddExState(void *v, uint32 s, int type, char *desc)
 		}
 	}
 	SFMDATA[SFEXINDEX].v=0;		// End marker.
+	rawLayoutValid=false;
 }
 
 void FCEUI_SelectStateNext(int n)
@@ -32,6 +32,18 @@ bool FCEUSS_SaveMS(EMUFILE* outstream, int compressionLevel);
 
 bool FCEUSS_LoadFP(EMUFILE* is, ENUM_SSLOADPARAMS params);
 
+//CRC32s of the live cpu, ppu, apu and mapper state, taken from the same tables savestates are written from.
+#define FCEUSS_DIGESTS 4
+void FCEUSS_Digest(uint32 digest[FCEUSS_DIGESTS]);
+
+//Raw snapshots of the running game: every region of the savestate tables copied
+//back to back into a caller-owned buffer of FCEUSS_RawSize() bytes. There are no
+//chunk tags, no compression, no back buffer and no backup, and movie checks are
+//skipped, so a snapshot is only good for the same game in the same process.
+uint32 FCEUSS_RawSize(void);
+bool FCEUSS_RawSave(uint8 *buf, uint32 size);
+bool FCEUSS_RawLoad(const uint8 *buf, uint32 size);
+
 extern int CurrentState;
 void FCEUSS_CheckStates(void);
 
@@ -56,8 +68,11 @@ void AddExState(void *v, uint32 s, int type, char *desc);
 //void*v is actually a void** which will be indirected before reading
 #define FCEUSTATE_INDIRECT            0x40000000
 
+//the value is only read from older savestates; it is never written and isn't part of digests or raw snapshots
+#define FCEUSTATE_LOADONLY            0x20000000
+
 //all FCEUSTATE flags together so that we can mask them out and get the size
-#define FCEUSTATE_FLAGS (FCEUSTATE_RLSB|FCEUSTATE_INDIRECT)
+#define FCEUSTATE_FLAGS (FCEUSTATE_RLSB|FCEUSTATE_INDIRECT|FCEUSTATE_LOADONLY)
 
 void FCEU_DrawSaveStates(uint8 *XBuf);
 
@@ -42,6 +42,9 @@ void md5_process( struct md5_context *ctx, uint8 data[64] )
 {
     uint32 A, B, C, D, X[16];
 
+#ifdef LSB_FIRST
+    memcpy( X, data, 64 );
+#else
     GET_UINT32( X[0],  data,  0 );
     GET_UINT32( X[1],  data,  4 );
     GET_UINT32( X[2],  data,  8 );
@@ -58,12 +61,15 @@ void md5_process( struct md5_context *ctx, uint8 data[64] )
     GET_UINT32( X[13], data, 52 );
     GET_UINT32( X[14], data, 56 );
     GET_UINT32( X[15], data, 60 );
+#endif
 
 #define S(x,n) ((x << n) | ((x & 0xFFFFFFFF) >> (32 - n)))
 
+// the message word and constant are added first, so only F and the
+// rotate sit on the dependency chain through b
 #define P(a,b,c,d,k,s,t)        \
 {                   \
-    a += F(b,c,d) + X[k] + t; a = S(a,s) + b;     \
+    a += X[k] + t; a += F(b,c,d); a = S(a,s) + b;     \
 }
 
     A = ctx->state[0];
@@ -92,26 +98,31 @@ void md5_process( struct md5_context *ctx, uint8 data[64] )
 
 #undef F
 
-#define F(x,y,z) (y ^ (z & (x ^ y)))
-
-    P( A, B, C, D,  1,  5, 0xF61E2562 );
-    P( D, A, B, C,  6,  9, 0xC040B340 );
-    P( C, D, A, B, 11, 14, 0x265E5A51 );
-    P( B, C, D, A,  0, 20, 0xE9B6C7AA );
-    P( A, B, C, D,  5,  5, 0xD62F105D );
-    P( D, A, B, C, 10,  9, 0x02441453 );
-    P( C, D, A, B, 15, 14, 0xD8A1E681 );
-    P( B, C, D, A,  4, 20, 0xE7D3FBC8 );
-    P( A, B, C, D,  9,  5, 0x21E1CDE6 );
-    P( D, A, B, C, 14,  9, 0xC33707D6 );
-    P( C, D, A, B,  3, 14, 0xF4D50D87 );
-    P( B, C, D, A,  8, 20, 0x455A14ED );
-    P( A, B, C, D, 13,  5, 0xA9E3E905 );
-    P( D, A, B, C,  2,  9, 0xFCEFA3F8 );
-    P( C, D, A, B,  7, 14, 0x676F02D9 );
-    P( B, C, D, A, 12, 20, 0x8D2A4C8A );
+// G(x,y,z) = (x & z) | (y & ~z): the two halves never overlap, so they
+// can be added separately and the one that doesn't need b goes first
+#define G(a,b,c,d,k,s,t)        \
+{                   \
+    a += X[k] + t; a += (c & ~d); a += (b & d); a = S(a,s) + b;     \
+}
 
-#undef F
+    G( A, B, C, D,  1,  5, 0xF61E2562 );
+    G( D, A, B, C,  6,  9, 0xC040B340 );
+    G( C, D, A, B, 11, 14, 0x265E5A51 );
+    G( B, C, D, A,  0, 20, 0xE9B6C7AA );
+    G( A, B, C, D,  5,  5, 0xD62F105D );
+    G( D, A, B, C, 10,  9, 0x02441453 );
+    G( C, D, A, B, 15, 14, 0xD8A1E681 );
+    G( B, C, D, A,  4, 20, 0xE7D3FBC8 );
+    G( A, B, C, D,  9,  5, 0x21E1CDE6 );
+    G( D, A, B, C, 14,  9, 0xC33707D6 );
+    G( C, D, A, B,  3, 14, 0xF4D50D87 );
+    G( B, C, D, A,  8, 20, 0x455A14ED );
+    G( A, B, C, D, 13,  5, 0xA9E3E905 );
+    G( D, A, B, C,  2,  9, 0xFCEFA3F8 );
+    G( C, D, A, B,  7, 14, 0x676F02D9 );
+    G( B, C, D, A, 12, 20, 0x8D2A4C8A );
+
+#undef G
     
 #define F(x,y,z) (x ^ y ^ z)
 
@@ -69,6 +69,53 @@ u8 *XDBackBuf=NULL; //corresponding to XBackBuf but with deemph bits
 int ClipSidesOffset=0;	//Used to move displayed messages when Clips left and right sides is checked
 static u8 *xbsave=NULL;
 
+//Per-scanline change tracking. Nothing is hashed while emulating: the displayed frame is hashed the first
+//time a consumer asks about it, and compared with the frame hashed before that.
+static uint64 lineHash[240];
+static uint8 lineDirty[240];
+static uint32 shownFrame = 1;     //bumped by every FCEU_PutImage
+static uint32 hashedFrame = 0;    //the frame lineHash describes, 0 for none
+
+static uint64 HashLine(const uint8 *line, const uint8 *dline)
+{
+	const uint64 *p = (const uint64*)line;
+	const uint64 *d = (const uint64*)dline;
+	uint64 h = 0x84222325CBF29CE4ULL;
+	for(int x=0;x<32;x++)
+	{
+		h = (h ^ p[x]) * 0x100000001B3ULL;
+		h ^= h >> 29;
+	}
+	for(int x=0;x<32;x++)
+		h = (h ^ d[x]) * 0x100000001B3ULL;
+	return h ^ (h >> 32);
+}
+
+static void HashLines(void)
+{
+	if(hashedFrame == shownFrame)
+		return;
+	for(int y=0;y<240;y++)
+	{
+		uint64 h = HashLine(XBuf + (y << 8), XDBuf + (y << 8));
+		lineDirty[y] = !hashedFrame || h != lineHash[y];
+		lineHash[y] = h;
+	}
+	hashedFrame = shownFrame;
+}
+
+const uint8 *FCEUI_GetDirtyLines(void)
+{
+	HashLines();
+	return lineDirty;
+}
+
+const uint64 *FCEUI_GetLineHashes(void)
+{
+	HashLines();
+	return lineHash;
+}
+
 GUIMESSAGE guiMessage;
 GUIMESSAGE subtitleMessage;
 
@@ -390,6 +437,7 @@ void FCEU_PutImage(void)
 		}
 	} else DrawMessage(false);
 
+	shownFrame++;
 }
 void snapAVI()
 {
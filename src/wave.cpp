@@ -24,11 +24,7 @@ void FCEU_WriteWaveData(int32 *Buffer, int Count)
  int16 *dest;
  int x;
 
-#ifndef WIN32
- if(!soundlog) return;
-#else
  if(!soundlog && !FCEUI_AviIsRecording()) return;
-#endif
 
  dest=temp;
  x=Count;
@@ -46,12 +42,10 @@ void FCEU_WriteWaveData(int32 *Buffer, int Count)
  if(soundlog)
 	 wsize+=fwrite(temp,1,Count*sizeof(int16),soundlog);
 
-	#ifdef WIN32
 	if(FCEUI_AviIsRecording())
 	{
 		FCEUI_AviSoundUpdate((void*)temp, Count);
 	}
-	#endif
 }
 
 int FCEUI_EndWaveRecord()
@@ -23,6 +23,8 @@
 #include "fceu.h"
 #include "debug.h"
 #include "sound.h"
+#include "cdl.h"
+#include "digest.h"
 #ifdef _S9XLUA_H
 #include "fceulua.h"
 #endif
@@ -47,6 +49,7 @@ void (*MapIRQHook)(int a);
 //normal memory read
 static INLINE uint8 RdMem(unsigned int A)
 {
+ if(cdl_enabled) FCEU_CDLRead(A, _PC);
  return(_DB=ARead[A](A));
 }
 
@@ -487,6 +490,8 @@ extern int test; test++;
 	//will probably cause a major speed decrease on low-end systems
    DEBUG( DebugCycle() );
 
+   if(digest_stepping) FCEU_DigestInstruction(_PC);
+
    IncrementInstructionsCounters();
 
    _PI=_P;